@@ -46,16 +46,39 @@ workspace("test")
     targetdir( "bin" )
 
     project( "01-unit-test" )
-        links({ "tess2", "glfw3", "glew", "z", "jpeg" })
+        links({ "tess2", "glfw3", "glew", "z", "lzma", "jpeg", "pthread" })
         linkoptions { "-framework OpenGL", "-framework Cocoa", "-framework IOKit", "-framework CoreVideo" }
         files({ "test/01-unit-test/*.cpp", "test/00-common/*.cpp", "source/**.cpp" })
 
     project("02-simple-shape")
-        links({ "tess2", "glfw3", "glew", "z", "jpeg" })
+        links({ "tess2", "glfw3", "glew", "z", "lzma", "jpeg", "pthread" })
         linkoptions { "-framework OpenGL", "-framework Cocoa", "-framework IOKit", "-framework CoreVideo" }
         files({ "test/02-simple-shape/*.cpp", "test/00-common/*.cpp", "source/**.cpp" })
 
     project("03-simple-timeline")
-        links({ "tess2", "glfw3", "glew", "z", "jpeg", "openswf" })
+        links({ "tess2", "glfw3", "glew", "z", "lzma", "jpeg", "pthread", "openswf" })
         linkoptions { "-framework OpenGL", "-framework Cocoa", "-framework IOKit", "-framework CoreVideo" }
         files({ "test/03-simple-timeline/*.cpp", "test/00-common/*.cpp", "source/**.cpp" })
+
+    project("04-stream-benchmark")
+        buildoptions({ "-O2" })
+        links({ "tess2", "glfw3", "glew", "z", "lzma", "jpeg", "pthread" })
+        linkoptions { "-framework OpenGL", "-framework Cocoa", "-framework IOKit", "-framework CoreVideo" }
+        files({ "test/04-stream-benchmark/*.cpp", "test/00-common/*.cpp", "source/**.cpp" })
+
+workspace("tools")
+    configurations( "release" )
+    location( "build/tools" )
+    defines({ "NDEBUG" })
+    optimize( "On" )
+    kind( "ConsoleApp" )
+    libdirs({ "libs/3rd", "libs", "/usr/local/lib/" })
+    includedirs({ "3rd/libtess2/Include", "/usr/local/include", "source" })
+    language( "C++" )
+    buildoptions({"-std=c++11", "-stdlib=libc++"})
+    targetdir( "bin" )
+
+    project("action-compiler")
+        links({ "tess2", "glfw3", "glew", "z", "lzma", "jpeg", "pthread" })
+        linkoptions { "-framework OpenGL", "-framework Cocoa", "-framework IOKit", "-framework CoreVideo" }
+        files({ "tools/action-compiler/*.cpp", "source/**.cpp" })
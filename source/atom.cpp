@@ -0,0 +1,42 @@
+#include "atom.hpp"
+
+namespace openswf
+{
+    // FNV-1a
+    size_t AtomTable::KeyHash::operator()(const Key& key) const
+    {
+        uint32_t hash = 2166136261u;
+        for( size_t i=0; i<key.size; i++ )
+        {
+            hash ^= (uint8_t)key.data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    Atom AtomTable::intern(const char* str, size_t size)
+    {
+        if( size == 0 )
+            return Atom();
+
+        auto found = m_atoms.find(Key { str, size });
+        if( found != m_atoms.end() )
+            return Atom(found->second.get());
+
+        // the key refers to the bytes owned by atom
+        auto atom = new std::string(str, size);
+        m_atoms[Key { atom->data(), atom->size() }] = StringPtr(atom);
+        return Atom(atom);
+    }
+
+    Atom AtomTable::find(const char* str, size_t size) const
+    {
+        if( size == 0 )
+            return Atom();
+
+        auto found = m_atoms.find(Key { str, size });
+        if( found != m_atoms.end() )
+            return Atom(found->second.get());
+        return Atom();
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace openswf
+{
+    // an interned string, atoms of the same table are equal if and only if
+    // their strings are equal, so they are compared and hashed by pointer.
+    // the default atom is the empty string.
+    class Atom
+    {
+    protected:
+        const std::string*  m_string;
+
+    public:
+        Atom() : m_string(nullptr) {}
+        explicit Atom(const std::string* str) : m_string(str) {}
+
+        bool                empty() const;
+        const std::string&  str() const;
+        const char*         c_str() const;
+
+        bool operator == (const Atom& rh) const { return m_string == rh.m_string; }
+        bool operator != (const Atom& rh) const { return m_string != rh.m_string; }
+
+        friend struct std::hash<Atom>;
+    };
+
+    class AtomTable
+    {
+        struct Key
+        {
+            const char* data;
+            size_t      size;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct KeyEqual
+        {
+            bool operator()(const Key& lh, const Key& rh) const
+            {
+                return lh.size == rh.size && memcmp(lh.data, rh.data, lh.size) == 0;
+            }
+        };
+
+        typedef std::unique_ptr<std::string> StringPtr;
+        typedef std::unordered_map<Key, StringPtr, KeyHash, KeyEqual> Atoms;
+
+    protected:
+        Atoms   m_atoms;
+
+    public:
+        Atom    intern(const char* str, size_t size);
+        Atom    intern(const char* str);
+        Atom    intern(const std::string& str);
+
+        // returns the empty atom if the string has never been interned,
+        // nothing is allocated.
+        Atom    find(const char* str, size_t size) const;
+        size_t  size() const;
+    };
+
+    /// INLINE METHODS
+    inline bool Atom::empty() const
+    {
+        return m_string == nullptr;
+    }
+
+    inline const std::string& Atom::str() const
+    {
+        const static std::string s_empty;
+        return m_string == nullptr ? s_empty : *m_string;
+    }
+
+    inline const char* Atom::c_str() const
+    {
+        return m_string == nullptr ? "" : m_string->c_str();
+    }
+
+    inline Atom AtomTable::intern(const char* str)
+    {
+        return intern(str, strlen(str));
+    }
+
+    inline Atom AtomTable::intern(const std::string& str)
+    {
+        return intern(str.data(), str.size());
+    }
+
+    inline size_t AtomTable::size() const
+    {
+        return m_atoms.size();
+    }
+}
+
+namespace std
+{
+    template<> struct hash<openswf::Atom>
+    {
+        size_t operator()(const openswf::Atom& atom) const
+        {
+            return std::hash<const void*>()(atom.m_string);
+        }
+    };
+}
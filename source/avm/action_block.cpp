@@ -0,0 +1,490 @@
+#include "avm/action_block.hpp"
+#include "avm/context_object.hpp"
+
+#include "stream.hpp"
+
+#include <algorithm>
+
+NS_AVM_BEGIN
+
+// executions of a block before its compiled into native code
+const static uint32_t JitThreshold = 16;
+
+ActionBlockPtr ActionBlock::compile(const uint8_t* bytes, uint32_t size, AtomTable& atoms, int32_t version)
+{
+    auto block = new (std::nothrow) ActionBlock();
+    auto stream = Stream(bytes, size);
+    if( block && block->initialize(stream, atoms) )
+    {
+        // translated functions refer to the records as they are
+        block->m_precompiled = PrecompiledRegistry::get_instance().find(bytes, size);
+        if( block->m_precompiled == nullptr && version > 0 )
+            block->optimize(version, atoms);
+        return ActionBlockPtr(block);
+    }
+
+    if( block ) delete block;
+    return nullptr;
+}
+
+bool ActionBlock::initialize(Stream& stream, AtomTable& atoms)
+{
+    // the offsets of records, and the offsets that branches jump to
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> branches;
+
+    auto size = stream.get_size();
+    while( stream.get_position() < size )
+    {
+        auto offset = stream.get_position();
+        auto code = (Opcode)stream.read_uint8();
+        if( code == Opcode::END )
+            break;
+
+        // the codes of superinstructions are not valid in files
+        if( code == Opcode::IF_NOT || code == Opcode::PUSH_GET_VARIABLE )
+            code = Opcode::END;
+
+        uint32_t length = 0;
+        if( (uint8_t)code >= 0x80 ) length = stream.read_uint16();
+
+        auto finish = stream.get_position() + length;
+        if( finish > size )
+        {
+            LWARNING(LOG_AVM, "action %s at %d is truncated.\n", opcode_to_string(code), offset);
+            break;
+        }
+
+        ActionRecord record;
+        record.handler  = ContextObject::get_handler(code);
+        record.code     = code;
+        record.operand  = 0;
+        record.count    = 0;
+
+        switch( code )
+        {
+            case Opcode::GOTO_FRAME:
+            {
+                record.operand = stream.read_uint16();
+                break;
+            }
+
+            case Opcode::GOTO_LABEL:
+            {
+                record.operand = m_atoms.size();
+                record.count = 1;
+                m_atoms.push_back(atoms.intern(stream.read_string()));
+                break;
+            }
+
+            case Opcode::CONSTANT_POOL:
+            {
+                record.operand = m_atoms.size();
+                record.count = stream.read_uint16();
+                for( uint32_t i=0; i<record.count; i++ )
+                    m_atoms.push_back(atoms.intern(stream.read_string()));
+                break;
+            }
+
+            case Opcode::PUSH:
+            {
+                read_push(stream, record, finish, atoms);
+                break;
+            }
+
+            case Opcode::JUMP:
+            case Opcode::IF:
+            {
+                // the offset is relative to the following action, its
+                // resolved into the index of record once all are read. a
+                // branch before the block ends it, as one past the end.
+                auto target = (int32_t)finish + stream.read_int16();
+                record.operand = branches.size();
+                branches.push_back(target < 0 ? size : (uint32_t)target);
+                break;
+            }
+
+            case Opcode::GET_VARIABLE:
+            case Opcode::SET_VARIABLE:
+            case Opcode::GET_MEMBER:
+            case Opcode::SET_MEMBER:
+            {
+                record.operand = m_caches.size();
+                m_caches.emplace_back();
+                break;
+            }
+
+            default:
+                break;
+        }
+
+        offsets.push_back(offset);
+        m_records.push_back(record);
+        stream.set_position(finish);
+    }
+
+    // a branch to the middle of an action, or out of block, ends the block
+    for( auto& record : m_records )
+    {
+        if( record.code != Opcode::JUMP && record.code != Opcode::IF )
+            continue;
+
+        auto target = branches[record.operand];
+        auto found = std::lower_bound(offsets.begin(), offsets.end(), target);
+        if( found != offsets.end() && *found == target )
+            record.operand = found - offsets.begin();
+        else
+            record.operand = m_records.size();
+    }
+
+    return true;
+}
+
+// the records of block while its optimized, the branch targets and ids
+// are the indices of records before optimizing, so a record removed is
+// replaced by the following one as the target of branches.
+struct Instruction
+{
+    uint32_t                    id;
+    ActionRecord                record;
+    std::vector<ActionOperand>  operands;   // of Push
+    bool                        target;
+};
+
+static bool is_branch(Opcode code)
+{
+    return code == Opcode::JUMP || code == Opcode::IF || code == Opcode::IF_NOT;
+}
+
+// the arity of actions folded if their operands are literals
+static int get_folding_arity(Opcode code)
+{
+    switch( code )
+    {
+        case Opcode::ADD:
+        case Opcode::SUBTRACT:
+        case Opcode::MULTIPLY:
+        case Opcode::DIVIDE:
+        case Opcode::EQUALS:
+        case Opcode::LESS:
+        case Opcode::GREATER:
+        case Opcode::AND:
+        case Opcode::OR:
+            return 2;
+
+        case Opcode::NOT:
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+static bool is_literal(const ActionOperand& operand)
+{
+    return operand.type != OpPushCode::CONSTANT8 && operand.type != OpPushCode::CONSTANT16;
+}
+
+// the same passes are repeated until nothing changes:
+// adjacent pushes are merged, literals are folded by the semantics of
+// handlers, branches over literal conditions are resolved, pushes popped
+// at once are removed, so are jumps to the next record and unreachable
+// records. Not and If, and Push of a name and GetVariable are fused into
+// superinstructions. records entered by branches are never merged into
+// the previous ones, so the stack is the same wherever a branch lands.
+void ActionBlock::optimize(int32_t version, AtomTable& atoms)
+{
+    auto count = (uint32_t)m_records.size();
+
+    std::vector<Instruction> code;
+    code.reserve(count);
+    for( uint32_t i=0; i<count; i++ )
+    {
+        Instruction ins;
+        ins.id = i;
+        ins.record = m_records[i];
+        ins.target = false;
+        if( ins.record.code == Opcode::PUSH )
+        {
+            auto first = m_operands.begin() + ins.record.operand;
+            ins.operands.assign(first, first + ins.record.count);
+        }
+        code.push_back(std::move(ins));
+    }
+
+    auto value_of = [&](const ActionOperand& operand)
+    {
+        return operand.type == OpPushCode::STRING ?
+            Value().set_atom(m_atoms[operand.index]) : operand.value;
+    };
+
+    auto operand_of = [&](Value value)
+    {
+        ActionOperand operand;
+        operand.index = 0;
+        operand.value = value;
+        switch( value.get_type() )
+        {
+            case ValueCode::STRING:
+                operand.type = OpPushCode::STRING;
+                operand.index = m_atoms.size();
+                m_atoms.push_back(value.to_atom());
+                break;
+
+            case ValueCode::BOOLEAN:
+                operand.type = OpPushCode::BOOLEAN;
+                break;
+
+            default:
+                operand.type = OpPushCode::DOUBLE;
+                break;
+        }
+        return operand;
+    };
+
+    // branches landing on a record removed land on the next one
+    auto remove = [&](size_t index)
+    {
+        if( code[index].target && index+1 < code.size() )
+            code[index+1].target = true;
+        code.erase(code.begin() + index);
+    };
+
+    auto changed = true;
+    while( changed )
+    {
+        changed = false;
+
+        // a record is a target if a branch lands on it, or on the removed
+        // records right before it.
+        for( auto& ins : code )
+            ins.target = false;
+
+        for( auto& ins : code )
+        {
+            if( !is_branch(ins.record.code) )
+                continue;
+
+            auto found = std::lower_bound(code.begin(), code.end(), ins.record.operand,
+                [](const Instruction& a, uint32_t id) { return a.id < id; });
+            if( found != code.end() )
+                found->target = true;
+        }
+
+        for( size_t i=0; i<code.size(); i++ )
+        {
+            auto& ins = code[i];
+            auto previous = i > 0 && code[i-1].record.code == Opcode::PUSH ? &code[i-1] : nullptr;
+            auto& operands = previous ? previous->operands : ins.operands;
+            auto arity = get_folding_arity(ins.record.code);
+
+            if( ins.target )
+                previous = nullptr;
+
+            // Push, Push
+            if( previous && ins.record.code == Opcode::PUSH )
+            {
+                operands.insert(operands.end(), ins.operands.begin(), ins.operands.end());
+                remove(i--);
+                changed = true;
+            }
+            // Push of literals, Add
+            else if( previous && arity > 0 && operands.size() >= (size_t)arity &&
+                std::all_of(operands.end() - arity, operands.end(), is_literal) )
+            {
+                auto op1 = value_of(operands.back());
+                auto op2 = arity > 1 ? value_of(operands[operands.size()-2]) : Value();
+                auto result = ContextObject::evaluate(ins.record.code, op2, op1, version, atoms);
+
+                operands.resize(operands.size() - arity);
+                operands.push_back(operand_of(result));
+                remove(i--);
+                changed = true;
+            }
+            // Push of a literal, If
+            else if( previous && (ins.record.code == Opcode::IF || ins.record.code == Opcode::IF_NOT) &&
+                !operands.empty() && is_literal(operands.back()) )
+            {
+                auto value = value_of(operands.back());
+                auto taken = ins.record.code == Opcode::IF ? value.to_boolean() : value.to_number() == 0;
+
+                operands.pop_back();
+                if( taken )
+                {
+                    ins.record.code = Opcode::JUMP;
+                    ins.record.handler = ContextObject::get_handler(Opcode::JUMP);
+                }
+                else
+                    remove(i--);
+                changed = true;
+            }
+            // Push, Pop
+            else if( previous && ins.record.code == Opcode::POP && !operands.empty() )
+            {
+                operands.pop_back();
+                remove(i--);
+                changed = true;
+            }
+            // Push of a name, GetVariable
+            else if( previous && ins.record.code == Opcode::GET_VARIABLE &&
+                !operands.empty() && operands.back().type == OpPushCode::STRING )
+            {
+                ins.record.code = Opcode::PUSH_GET_VARIABLE;
+                ins.record.handler = ContextObject::get_handler(Opcode::PUSH_GET_VARIABLE);
+                ins.record.count = operands.back().index;
+                operands.pop_back();
+                changed = true;
+            }
+            // Not, If
+            else if( ins.record.code == Opcode::NOT && i+1 < code.size() &&
+                code[i+1].record.code == Opcode::IF && !code[i+1].target )
+            {
+                ins.record.code = Opcode::IF_NOT;
+                ins.record.handler = ContextObject::get_handler(Opcode::IF_NOT);
+                ins.record.operand = code[i+1].record.operand;
+                remove(i+1);
+                changed = true;
+            }
+            // Push of nothing is left by the passes above
+            else if( ins.record.code == Opcode::PUSH && ins.operands.empty() )
+            {
+                remove(i--);
+                changed = true;
+            }
+            // Jump to the next record
+            else if( ins.record.code == Opcode::JUMP && ins.record.operand > ins.id &&
+                ins.record.operand <= (i+1 < code.size() ? code[i+1].id : count) )
+            {
+                remove(i--);
+                changed = true;
+            }
+            // records after Jump are unreachable until a target
+            else if( ins.record.code == Opcode::JUMP && i+1 < code.size() && !code[i+1].target )
+            {
+                remove(i+1);
+                changed = true;
+            }
+        }
+    }
+
+    // the ids of records removed are mapped to the next ones
+    std::vector<uint32_t> indices(count+1, 0);
+    for( uint32_t id=0, k=0; id<=count; id++ )
+    {
+        while( k < code.size() && code[k].id < id ) k++;
+        indices[id] = k;
+    }
+
+    m_records.clear();
+    m_operands.clear();
+    for( auto& ins : code )
+    {
+        auto record = ins.record;
+        if( record.code == Opcode::PUSH )
+        {
+            record.operand = m_operands.size();
+            record.count = ins.operands.size();
+            m_operands.insert(m_operands.end(), ins.operands.begin(), ins.operands.end());
+        }
+        else if( is_branch(record.code) )
+            record.operand = indices[std::min(record.operand, count)];
+
+        m_records.push_back(record);
+    }
+
+    LDEBUG(LOG_AVM, "optimized %d actions into %d.\n", count, (int)m_records.size());
+}
+
+const NativeBlock* ActionBlock::get_native(const MovieEnvironment& env) const
+{
+    if( m_executions < JitThreshold && ++m_executions == JitThreshold )
+    {
+        m_native = NativeBlock::compile(*this, env);
+        if( m_native == nullptr )
+            LDEBUG(LOG_AVM, "native code is not available, keep interpreting.\n");
+    }
+
+    return m_native.get();
+}
+
+void ActionBlock::read_push(Stream& stream, ActionRecord& record, uint32_t finish, AtomTable& atoms)
+{
+    record.operand = m_operands.size();
+    while( stream.get_position() < finish )
+    {
+        ActionOperand operand;
+        operand.type = (OpPushCode)stream.read_uint8();
+        operand.index = 0;
+
+        switch( operand.type )
+        {
+            case OpPushCode::STRING:
+            {
+                operand.index = m_atoms.size();
+                m_atoms.push_back(atoms.intern(stream.read_string()));
+                break;
+            }
+
+            case OpPushCode::FLOAT:
+            {
+                operand.value.set_number(stream.read_float32());
+                break;
+            }
+
+            case OpPushCode::BOOLEAN:
+            {
+                operand.value.set_boolean(stream.read_uint8());
+                break;
+            }
+
+            case OpPushCode::DOUBLE:
+            {
+                operand.value.set_number(stream.read_float64());
+                break;
+            }
+
+            case OpPushCode::INTEGER:
+            {
+                operand.value.set_integer(stream.read_uint32());
+                break;
+            }
+
+            case OpPushCode::NIL:
+            {
+                operand.value.set_nil();
+                break;
+            }
+
+            case OpPushCode::REGISTER:
+            {
+                // registers are not supported yet, its pushed as undefined
+                stream.read_uint8();
+                operand.type = OpPushCode::UNDEFINED;
+                break;
+            }
+
+            case OpPushCode::CONSTANT8:
+            {
+                operand.index = stream.read_uint8();
+                break;
+            }
+
+            case OpPushCode::CONSTANT16:
+            {
+                operand.index = stream.read_uint16();
+                break;
+            }
+
+            default:
+            {
+                operand.type = OpPushCode::UNDEFINED;
+                break;
+            }
+        }
+
+        m_operands.push_back(operand);
+        record.count ++;
+    }
+}
+
+NS_AVM_END
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "avm/avm.hpp"
+#include "avm/jit.hpp"
+#include "avm/object_layout.hpp"
+#include "avm/opcode.hpp"
+#include "avm/precompiled.hpp"
+#include "avm/value.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+NS_AVM_BEGIN
+
+struct MovieEnvironment;
+typedef void (*ActionHandler)(MovieEnvironment&);
+
+enum class OpPushCode : uint8_t
+{
+    STRING = 0,
+    FLOAT,
+    NIL,
+    UNDEFINED,
+    REGISTER,
+    BOOLEAN,
+    DOUBLE,
+    INTEGER,
+    CONSTANT8,
+    CONSTANT16
+};
+
+struct ActionOperand
+{
+    OpPushCode  type;
+    uint32_t    index;  // in the atoms of block, or in the constant pool
+    Value       value;  // numbers, booleans, null and undefined
+};
+
+struct ActionRecord
+{
+    ActionHandler   handler;
+    Opcode          code;
+    uint32_t        operand;    // branch target, frame, property cache, or the first operand or atom
+    uint32_t        count;      // number of operands or atoms, or the atom of a fused name
+};
+
+class ActionBlock;
+typedef std::unique_ptr<ActionBlock> ActionBlockPtr;
+
+// the bytecode of a DoAction tag decoded once into a array of records, the
+// handlers, branch targets and operands of records are resolved, so the
+// interpreter dispatches a record by calling its handler directly. string
+// literals and constant pools are interned as atoms. every access of variables
+// and members has its own property cache. blocks executed often are compiled
+// into native code if the virtual machine enables it, and blocks translated
+// ahead of time run their precompiled functions instead.
+class ActionBlock
+{
+protected:
+    std::vector<ActionRecord>   m_records;
+    std::vector<ActionOperand>  m_operands;
+    std::vector<Atom>           m_atoms;
+    mutable std::vector<PropertyCache>  m_caches;
+    mutable uint32_t                    m_executions;
+    mutable NativeBlockPtr              m_native;
+    PrecompiledActions                  m_precompiled;
+    uint16_t                            m_character_id;
+    uint16_t                            m_frame;
+
+public:
+    // compiles the actions until an End action, or the end of bytes. the
+    // records are optimized for the swf version of file unless its 0, or
+    // the bytecode has been translated ahead of time.
+    static ActionBlockPtr compile(const uint8_t* bytes, uint32_t size, AtomTable& atoms, int32_t version = 0);
+
+    uint32_t                get_record_count() const;
+    const ActionRecord&     get_record(uint32_t index) const;
+    const ActionOperand&    get_operand(uint32_t index) const;
+    Atom                    get_atom(uint32_t index) const;
+    PropertyCache&          get_cache(uint32_t index) const;
+
+    // counts an execution, and returns the native code once the block is
+    // hot, or nullptr if its not compiled.
+    const NativeBlock*      get_native(const MovieEnvironment& env) const;
+    // the function of registered bytecode, or nullptr
+    PrecompiledActions      get_precompiled() const;
+
+    // the movie clip and frame of DoAction tag, which scripts are profiled by
+    void                    set_origin(uint16_t character_id, uint16_t frame);
+    uint16_t                get_character_id() const;
+    uint16_t                get_frame() const;
+
+protected:
+    ActionBlock() : m_executions(0), m_precompiled(nullptr), m_character_id(0), m_frame(0) {}
+    bool initialize(Stream& stream, AtomTable& atoms);
+    void optimize(int32_t version, AtomTable& atoms);
+    void read_push(Stream& stream, ActionRecord& record, uint32_t finish, AtomTable& atoms);
+};
+
+// INLINE METHODS
+inline uint32_t ActionBlock::get_record_count() const
+{
+    return m_records.size();
+}
+
+inline const ActionRecord& ActionBlock::get_record(uint32_t index) const
+{
+    return m_records[index];
+}
+
+inline const ActionOperand& ActionBlock::get_operand(uint32_t index) const
+{
+    return m_operands[index];
+}
+
+inline Atom ActionBlock::get_atom(uint32_t index) const
+{
+    return m_atoms[index];
+}
+
+inline PrecompiledActions ActionBlock::get_precompiled() const
+{
+    return m_precompiled;
+}
+
+inline void ActionBlock::set_origin(uint16_t character_id, uint16_t frame)
+{
+    m_character_id = character_id;
+    m_frame = frame;
+}
+
+inline uint16_t ActionBlock::get_character_id() const
+{
+    return m_character_id;
+}
+
+inline uint16_t ActionBlock::get_frame() const
+{
+    return m_frame;
+}
+
+inline PropertyCache& ActionBlock::get_cache(uint32_t index) const
+{
+    return m_caches[index];
+}
+
+NS_AVM_END
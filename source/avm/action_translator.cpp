@@ -0,0 +1,242 @@
+#include "avm/action_translator.hpp"
+#include "avm/context_object.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+NS_AVM_BEGIN
+
+static std::string format(const char* fmt, ...)
+{
+    char buffer[256];
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+
+    return buffer;
+}
+
+// a c++ expression of the literal, 17 digits are enough for doubles to be exact
+static std::string to_literal(const Value& value)
+{
+    switch( value.get_type() )
+    {
+        case ValueCode::NUMBER:
+        {
+            auto d = value.to_number();
+            if( std::isnan(d) )
+                return "Value().set_number(std::numeric_limits<double>::quiet_NaN())";
+            if( std::isinf(d) )
+                return d > 0 ?
+                    "Value().set_number(std::numeric_limits<double>::infinity())" :
+                    "Value().set_number(-std::numeric_limits<double>::infinity())";
+            return format("Value().set_number(%.17g)", d);
+        }
+
+        case ValueCode::INTEGER:
+            return format("Value().set_integer(%d)", value.to_integer());
+
+        case ValueCode::BOOLEAN:
+            return value.to_boolean() ? "Value().set_boolean(true)" : "Value().set_boolean(false)";
+
+        case ValueCode::NULLPTR:
+            return "Value().set_nil()";
+
+        default:
+            return "Value()";
+    }
+}
+
+std::string ActionTranslator::translate(const ActionBlock& block, const std::string& name)
+{
+    auto count = block.get_record_count();
+
+    // only the targets of branches are labeled
+    std::vector<bool> targets(count+1, false);
+    for( uint32_t i=0; i<count; i++ )
+    {
+        auto& record = block.get_record(i);
+        if( record.code == Opcode::JUMP || record.code == Opcode::IF || record.code == Opcode::IF_NOT )
+            targets[std::min(record.operand, count)] = true;
+    }
+
+    auto label = [&](uint32_t index)
+    {
+        return index < count ? format("L%d", index) : std::string("finish");
+    };
+
+    // a loop is charged at its backward branch, see MovieEnvironment::charge
+    auto branch = [&](uint32_t index, uint32_t target) -> std::string
+    {
+        if( target > index )
+            return "goto " + label(std::min(target, count)) + ";";
+
+        return format("{ env.next = %d; if( !env.charge(%d) ) return; goto %s; }",
+            target, index + 1 - target, label(target).c_str());
+    };
+
+    std::string source;
+    source += format("static void %s(MovieEnvironment& env)\n{\n", name.c_str());
+    source += "    auto block = env.block;\n";
+    source += "    (void)block;\n\n";
+
+    for( uint32_t i=0; i<count; i++ )
+    {
+        auto& record = block.get_record(i);
+
+        if( targets[i] )
+            source += label(i) + ":\n";
+        std::string comment = opcode_to_string(record.code);
+        comment.erase(comment.find_last_not_of(' ')+1);
+        source += "    // " + comment + "\n";
+
+        switch( record.code )
+        {
+            case Opcode::PUSH:
+            {
+                // the constant pool is known at runtime only
+                std::string pushes;
+                for( uint32_t k=0; k<record.count; k++ )
+                {
+                    auto& operand = block.get_operand(record.operand+k);
+                    if( operand.type == OpPushCode::CONSTANT8 || operand.type == OpPushCode::CONSTANT16 )
+                    {
+                        pushes.clear();
+                        break;
+                    }
+
+                    if( operand.type == OpPushCode::STRING )
+                        pushes += format("    env.push(Value().set_atom(block->get_atom(%d)));\n", operand.index);
+                    else
+                        pushes += "    env.push(" + to_literal(operand.value) + ");\n";
+                }
+
+                if( !pushes.empty() || record.count == 0 )
+                {
+                    source += pushes;
+                    break;
+                }
+
+                source += format("    env.record = &block->get_record(%d);\n", i);
+                source += "    env.record->handler(env);\n";
+                break;
+            }
+
+            case Opcode::POP:
+            {
+                source += "    env.pop();\n";
+                break;
+            }
+
+            case Opcode::ADD:
+            case Opcode::SUBTRACT:
+            case Opcode::MULTIPLY:
+            {
+                auto op = record.code == Opcode::ADD ? '+' : record.code == Opcode::SUBTRACT ? '-' : '*';
+                source += "    {\n";
+                source += "        auto op1 = env.pop().to_number();\n";
+                source += "        auto op2 = env.pop().to_number();\n";
+                source += format("        env.push(Value().set_number(op2 %c op1));\n", op);
+                source += "    }\n";
+                break;
+            }
+
+            case Opcode::JUMP:
+            {
+                source += "    " + branch(i, record.operand) + "\n";
+                break;
+            }
+
+            case Opcode::IF:
+            {
+                source += "    if( env.pop().to_boolean() ) " + branch(i, record.operand) + "\n";
+                break;
+            }
+
+            case Opcode::IF_NOT:
+            {
+                source += "    if( env.pop().to_number() == 0 ) " + branch(i, record.operand) + "\n";
+                break;
+            }
+
+            default:
+            {
+                source += format("    env.record = &block->get_record(%d);\n", i);
+                source += "    env.record->handler(env);\n";
+                break;
+            }
+        }
+    }
+
+    if( targets[count] )
+        source += "finish:\n    return;\n";
+    source += "}\n";
+    return source;
+}
+
+bool ActionTranslator::add(const uint8_t* bytes, uint32_t size)
+{
+    // a block colliding with another one is left to interpreter
+    auto hash = PrecompiledRegistry::hash(bytes, size);
+    if( m_hashes.find(hash) != m_hashes.end() )
+    {
+        for( auto& function : m_table )
+        {
+            if( function.hash == hash )
+                return function.size == size && memcmp(function.bytes.data(), bytes, size) == 0;
+        }
+    }
+
+    auto block = ActionBlock::compile(bytes, size, m_atoms);
+    if( block == nullptr )
+        return false;
+
+    Function function;
+    function.hash = hash;
+    function.size = size;
+    function.name = format("actions_%016llx", (unsigned long long)hash);
+    function.bytes.assign(bytes, bytes+size);
+
+    m_functions += translate(*block, function.name) + "\n";
+    m_table.push_back(function);
+    m_hashes.insert(hash);
+    return true;
+}
+
+std::string ActionTranslator::get_source() const
+{
+    std::string source;
+    source += "// generated by the action compiler of openswf, do not edit.\n";
+    source += "#include \"avm/context_object.hpp\"\n";
+    source += "#include \"avm/precompiled.hpp\"\n\n";
+    source += "#include <limits>\n\n";
+    source += "using namespace openswf::avm;\n\n";
+    source += m_functions;
+
+    if( m_table.empty() )
+        return source;
+
+    // the bytecode is kept to tell apart the blocks of colliding hashes
+    for( auto& function : m_table )
+    {
+        source += format("static const uint8_t %s_bytes[] =\n{", function.name.c_str());
+        for( uint32_t i=0; i<function.size; i++ )
+            source += format(i % 16 == 0 ? "\n    0x%02X," : " 0x%02X,", function.bytes[i]);
+        source += "\n};\n\n";
+    }
+
+    source += "static const PrecompiledEntry s_entries[] =\n{\n";
+    for( auto& function : m_table )
+        source += format("    { 0x%016llxULL, %u, %s_bytes, %s },\n",
+            (unsigned long long)function.hash, function.size, function.name.c_str(), function.name.c_str());
+    source += "};\n\n";
+    source += format("static PrecompiledRegistrar s_registrar(s_entries, %d);\n", (int)m_table.size());
+    return source;
+}
+
+NS_AVM_END
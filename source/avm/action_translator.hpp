@@ -0,0 +1,50 @@
+#pragma once
+
+#include "avm/avm.hpp"
+#include "avm/action_block.hpp"
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+NS_AVM_BEGIN
+
+// translates action blocks into c++ functions against the api of
+// MovieEnvironment, and a table registering them by the hash of bytecode,
+// see PrecompiledRegistry. its used by the action compiler offline.
+class ActionTranslator
+{
+    struct Function
+    {
+        uint64_t    hash;
+        uint32_t    size;
+        std::string name;
+        std::vector<uint8_t> bytes;
+    };
+
+protected:
+    AtomTable                       m_atoms;
+    std::string                     m_functions;
+    std::vector<Function>           m_table;
+    std::unordered_set<uint64_t>    m_hashes;
+
+public:
+    // translates the bytecode of a DoAction tag, blocks translated already
+    // are skipped. returns false if its not compiled, or its hash collides
+    // with another block.
+    bool        add(const uint8_t* bytes, uint32_t size);
+    // the source of all the functions added and their registration
+    std::string get_source() const;
+    uint32_t    get_function_count() const;
+
+    // the body of a static function running the block
+    static std::string translate(const ActionBlock& block, const std::string& name);
+};
+
+// INLINE METHODS
+inline uint32_t ActionTranslator::get_function_count() const
+{
+    return m_table.size();
+}
+
+NS_AVM_END
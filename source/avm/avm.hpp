@@ -3,8 +3,6 @@
 #include <cstdint>
 #include <cassert>
 
-#define DEBUG_AVM
-
 #define NS_OPENSWF_BEGIN namespace openswf {
 #define NS_OPENSWF_END }
 
@@ -26,10 +24,12 @@ NS_OPENSWF_END
 
 NS_AVM_BEGIN
 
+class ActionBlock;
 class GCObject;
 class ContextObject;
 class StringObject;
 class ScriptObject;
+class ScriptProfiler;
 class VirtualMachine;
 
 NS_AVM_END
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "avm/avm.hpp"
+#include "avm/action_block.hpp"
 #include "avm/script_object.hpp"
 
 #include <vector>
@@ -10,62 +11,99 @@ NS_AVM_BEGIN
 
 const static int MaxOperands = 32;
 
+enum class ExecutionStatus : uint8_t
+{
+    RUNNING = 0,
+    SUSPENDED,  // out of the instruction budget of frame, resumed from next
+    ABORTED     // ran longer than the timeout of ScriptLimits
+};
+
 struct MovieEnvironment
 {
-    VirtualMachine* vm;
-    ContextObject*    object;
-    MovieNode*      node;
-    Stream*         bytecode;
-    int32_t         version;
-    int32_t         finish;
+    friend class NativeBlock;
+
+    VirtualMachine*     vm;
+    ContextObject*      object;
+    MovieNode*          node;
+    const ActionBlock*  block;
+    const ActionRecord* record; // being executed
+    uint32_t            next;   // index of record executed next, changed by branches
+    int32_t             version;
+    ExecutionStatus     status;
+    uint64_t            started;    // microseconds when its run or resumed last time
+    uint64_t            elapsed;    // microseconds of running before that
 
 protected:
     Value           m_operands[MaxOperands];
     int             m_current_operand;
 
 public:
-    MovieEnvironment(VirtualMachine* vm, ContextObject* that, Stream* bc);
+    MovieEnvironment(VirtualMachine* vm, ContextObject* that, const ActionBlock* block);
 
     void    push(Value value);
     Value   pop();
     Value   back();
+    // pops the name of variable or member to store, other values than
+    // strings are converted and interned.
+    Atom    pop_name();
+    // pops the name to look up, computed names are not interned. returns
+    // false if the name has never been interned, so no object has it.
+    bool    find_name(Atom& name);
     int     get_current_op() const;
-    bool    is_finished() const;
+    Value   get_operand(int index) const;
+    // charges the instructions of a loop at its backward branch, returns
+    // false if execution should stop, see ExecutionStatus.
+    bool    charge(uint32_t instructions);
 };
 
 // ContextObject is the minimal runtime context in avm.
 class ContextObject : public ScriptObject
 {
     friend class VirtualMachine;
-    typedef std::unordered_map<std::string, Value> Scope;
+    typedef std::unordered_map<Atom, Value> Scope;
 
 protected:
-    std::vector<StringObject*>      m_constants;
+    std::vector<Atom>               m_constants;
     std::vector<Scope>              m_scope_chain;
     MovieNode*                      m_movie_node;
 
 public:
-    ContextObject();
+    explicit ContextObject(ObjectLayout* root);
 
-    void        execute(VirtualMachine& vm, Stream& bytecode);
+    // runs the block of environment, or resumes it from env.next.
+    void        execute(MovieEnvironment& env);
     bool        expired() const;
     MovieNode*  get_movie_node();
 
     void attach_movie(ContextObject*);
     void push_scope();
-    void set_local_variable(const char*, Value);
+    void set_local_variable(Atom, Value);
     void pop_scope();
 
-    virtual void mark(uint8_t);
+    virtual void trace(VirtualMachine&);
     virtual std::string to_string() const;
-    virtual Value get_variable(const char*);
+    virtual Value get_variable(Atom);
+    virtual Value get_variable(Atom, PropertyCache&);
+
+    // the handler of opcode which is resolved by ActionBlock once compiled.
+    static ActionHandler get_handler(Opcode);
+    // runs the records of block from env.next until the end.
+    static void interpret(MovieEnvironment& env);
+    // the same, and records the cycles of every action.
+    static void interpret(MovieEnvironment& env, ScriptProfiler& profiler);
+    // the result of a arithmetic, comparison or logical action, op1 is the
+    // operand popped first, and op2 is ignored by Not. its shared by the
+    // handlers and the constant folding of ActionBlock.
+    static Value evaluate(Opcode code, Value op2, Value op1, int32_t version, AtomTable& atoms);
 
 protected:
-    void attach(MovieNode*);
+    void attach(MovieNode*, AtomTable&);
     void detach();
     void set_scope();
+    void execute_differential(MovieEnvironment& env, const NativeBlock& native);
 
     static void initialize();
+    static void op_undefined(MovieEnvironment&);
 
     // swf3
     static void op_next_frame(MovieEnvironment&);
@@ -99,6 +137,7 @@ protected:
     // the value of the PC, and might create variable scope.
     static void op_jump(MovieEnvironment&);
     static void op_if(MovieEnvironment&);
+    static void op_if_not(MovieEnvironment&);
     // static void op_call(MovieEnvironment&); //
 
     //
@@ -108,6 +147,7 @@ protected:
     static void op_get_property(MovieEnvironment&); //
     static void op_set_variable(MovieEnvironment&); //
     static void op_get_variable(MovieEnvironment&);
+    static void op_push_get_variable(MovieEnvironment&);
     static void op_set_member(MovieEnvironment&);
     static void op_get_member(MovieEnvironment&);
 
@@ -143,6 +183,12 @@ inline int MovieEnvironment::get_current_op() const
     return m_current_operand;
 }
 
+inline Value MovieEnvironment::get_operand(int index) const
+{
+    assert(index>=0 && index<m_current_operand);
+    return m_operands[index];
+}
+
 inline bool ContextObject::expired() const
 {
     return m_movie_node == nullptr;
@@ -163,8 +209,9 @@ inline void ContextObject::pop_scope()
     m_scope_chain.pop_back();
 }
 
-inline void ContextObject::set_local_variable(const char* name, Value value)
+inline void ContextObject::set_local_variable(Atom name, Value value)
 {
+    write_barrier(value.to_object());
     m_scope_chain.back()[name] = value;
 }
 
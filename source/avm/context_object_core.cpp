@@ -6,25 +6,31 @@
 #include "stream.hpp"
 #include "movie_clip.hpp"
 
+#include <cstring>
+
 NS_AVM_BEGIN
 
 MovieEnvironment::MovieEnvironment(
-    VirtualMachine* vm, ContextObject* that, Stream* bc)
+    VirtualMachine* vm, ContextObject* that, const ActionBlock* block)
     : vm(vm), version(vm->get_version()),
     object(that), node(that->get_movie_node()),
-    bytecode(bc), m_current_operand(0) {}
+    block(block), record(nullptr), next(0),
+    status(ExecutionStatus::RUNNING), started(0), elapsed(0), m_current_operand(0) {}
 
-bool MovieEnvironment::is_finished() const
+bool MovieEnvironment::charge(uint32_t instructions)
 {
-    return bytecode->get_position() >= finish;
+    return vm->charge(*this, instructions);
 }
 
-typedef std::function<void(MovieEnvironment&)> OpHandler;
-static std::unordered_map<uint8_t, OpHandler> s_handlers;
+// a dense table indexed by opcode, undefined ones are logged only.
+static ActionHandler s_handlers[256];
 
 void ContextObject::initialize()
 {
-    if( s_handlers.size() != 0 ) return;
+    if( s_handlers[0] != nullptr ) return;
+
+    for( auto& handler : s_handlers )
+        handler = ContextObject::op_undefined;
     
     s_handlers[(uint8_t)Opcode::NEXT_FRAME]     = ContextObject::op_next_frame;
     s_handlers[(uint8_t)Opcode::PREV_FRAME]     = ContextObject::op_prev_frame;
@@ -49,10 +55,12 @@ void ContextObject::initialize()
 
     s_handlers[(uint8_t)Opcode::JUMP]           = ContextObject::op_jump;
     s_handlers[(uint8_t)Opcode::IF]             = ContextObject::op_if;
+    s_handlers[(uint8_t)Opcode::IF_NOT]         = ContextObject::op_if_not;
 
     s_handlers[(uint8_t)Opcode::DEFINE_LOCAL]   = ContextObject::op_define_local;
     // s_handlers[(uint8_t)Opcode::DEFINE_LOCAL2]  = ContextObject::op_define_local2;
     s_handlers[(uint8_t)Opcode::GET_VARIABLE]   = ContextObject::op_get_variable;
+    s_handlers[(uint8_t)Opcode::PUSH_GET_VARIABLE] = ContextObject::op_push_get_variable;
     s_handlers[(uint8_t)Opcode::SET_VARIABLE]   = ContextObject::op_set_variable;
     s_handlers[(uint8_t)Opcode::GET_PROPERTY]   = ContextObject::op_get_property;
     s_handlers[(uint8_t)Opcode::SET_PROPERTY]   = ContextObject::op_set_property;
@@ -63,6 +71,12 @@ void ContextObject::initialize()
     s_handlers[(uint8_t)Opcode::CONSTANT_POOL]  = ContextObject::op_constants;
 }
 
+ActionHandler ContextObject::get_handler(Opcode code)
+{
+    initialize();
+    return s_handlers[(uint8_t)code];
+}
+
 static void get_x()
 {
 
@@ -73,20 +87,20 @@ static void set_x()
 
 }
 
-ContextObject::ContextObject()
-: m_movie_node(nullptr)
+ContextObject::ContextObject(ObjectLayout* root)
+: ScriptObject(root), m_movie_node(nullptr)
 {
     initialize();
 }
 
-void ContextObject::attach(MovieNode* node)
+void ContextObject::attach(MovieNode* node, AtomTable& atoms)
 {
     push_scope();
 
     m_movie_node = node;
 
-    set_variable("this", Value().set_object(this));
-    set_variable("", Value().set_object(this));
+    set_variable(atoms.intern("this"), Value().set_object(this));
+    set_variable(Atom(), Value().set_object(this));
 }
 
 void ContextObject::detach()
@@ -96,7 +110,7 @@ void ContextObject::detach()
     m_constants.clear();
 }
 
-Value ContextObject::get_variable(const char* name)
+Value ContextObject::get_variable(Atom name)
 {
     for( int i=m_scope_chain.size()-1; i>=0; i-- )
     {
@@ -106,75 +120,175 @@ Value ContextObject::get_variable(const char* name)
     }
 
     auto value = ScriptObject::get_variable(name);
-    if( value.type != ValueCode::UNDEFINED )
+    if( value.get_type() != ValueCode::UNDEFINED )
         return value;
 
     return Value();
 }
 
-void ContextObject::execute(VirtualMachine& vm, Stream& bytecode)
+Value ContextObject::get_variable(Atom name, PropertyCache& cache)
+{
+    // locals shadow the properties, the scopes are usually empty or tiny
+    for( int i=m_scope_chain.size()-1; i>=0; i-- )
+    {
+        auto found = m_scope_chain[i].find(name);
+        if( found != m_scope_chain[i].end() )
+            return found->second;
+    }
+
+    return ScriptObject::get_variable(name, cache);
+}
+
+void ContextObject::execute(MovieEnvironment& env)
 {
    if( expired() )
    {
-       printf("[AVM] trying to execute action at a expired movie object.\n");
+       LERROR(LOG_AVM, "trying to execute action at a expired movie object.\n");
        assert(false);
        return;
    }
 
-    auto env = MovieEnvironment(&vm, this, &bytecode);
+    // actions are measured one by one by interpreter
+    auto profiler = env.vm->get_profiler();
+    if( profiler != nullptr )
+    {
+        interpret(env, *profiler);
+        assert( env.status != ExecutionStatus::RUNNING || env.get_current_op() == 0 );
+        return;
+    }
 
-    for(;;)
+    // a block suspended in the middle is resumed by interpreter
+    if( env.next > 0 )
     {
-        auto code = (Opcode)bytecode.read_uint8();
-        if( code == Opcode::END )
-        {
-            assert( env.get_current_op() == 0 );
-            return;
-        }
+        interpret(env);
+        assert( env.status != ExecutionStatus::RUNNING || env.get_current_op() == 0 );
+        return;
+    }
 
-        auto size = 0;
-        if( (uint8_t)code >= 0x80 ) size = bytecode.read_uint16();
-        env.finish = bytecode.get_position() + size;
+    // blocks translated ahead of time need no native code
+    auto& vm = *env.vm;
+    auto& block = *env.block;
+    auto precompiled = block.get_precompiled();
+    auto native = precompiled == nullptr && vm.get_jit_mode() != JitMode::DISABLED ?
+        block.get_native(env) : nullptr;
+
+    if( precompiled != nullptr )
+        precompiled(env);
+    else if( native == nullptr )
+        interpret(env);
+    else if( vm.get_jit_mode() == JitMode::DIFFERENTIAL )
+        execute_differential(env, *native);
+    else
+        native->run(env);
 
-        auto found = s_handlers.find((uint8_t)code);
-        if( found != s_handlers. end() )
-        {
-#ifdef DEBUG_AVM
-            printf("EXECUTE OP: %s(0x%X, %d)\n",
-                opcode_to_string(code), (uint32_t)code, size);
-#endif
-            found->second(env);
-        }
-        else
-        {
-#ifdef DEBUG_AVM
-            printf("[!] UNDEFINED OP: %s(0x%X, %d)\n",
-                opcode_to_string(code), (uint32_t)code, size);
-#endif
-        }
-        
-        bytecode.set_position(env.finish);
+    assert( env.status != ExecutionStatus::RUNNING || env.get_current_op() == 0 );
+}
+
+void ContextObject::interpret(MovieEnvironment& env)
+{
+    auto count = env.block->get_record_count();
+    while( env.next < count && env.status == ExecutionStatus::RUNNING )
+    {
+        env.record = &env.block->get_record(env.next++);
+
+        LTRACE(LOG_AVM, "EXECUTE OP: %s(0x%X)\n",
+            opcode_to_string(env.record->code), (uint32_t)env.record->code);
+        env.record->handler(env);
     }
 }
 
-void ContextObject::mark(uint8_t v)
+void ContextObject::interpret(MovieEnvironment& env, ScriptProfiler& profiler)
 {
-    if( get_marked_value() != 0 )
-        return;
+    auto count = env.block->get_record_count();
+    while( env.next < count && env.status == ExecutionStatus::RUNNING )
+    {
+        env.record = &env.block->get_record(env.next++);
+
+        auto code = env.record->code;
+        auto start = ScriptProfiler::now();
+        env.record->handler(env);
+        profiler.add_action(code, ScriptProfiler::now() - start);
+    }
+}
+
+static bool is_same(const Value& a, const Value& b)
+{
+    return memcmp(&a, &b, sizeof(Value)) == 0;
+}
+
+void ContextObject::execute_differential(MovieEnvironment& env, const NativeBlock& native)
+{
+    // the variables are restored before running natively, a dictionary is
+    // changed in place, so it is copied.
+    auto layout     = m_layout;
+    auto dictionary = m_dictionary ? m_dictionary->to_dictionary() : nullptr;
+    auto slots      = m_slots;
+    auto scopes     = m_scope_chain;
+    auto constants  = m_constants;
+    auto budget     = env.vm->m_instructions_left;
+
+    auto expected = env;
+    interpret(expected);
+    env.vm->m_instructions_left = budget;
+
+    std::swap(layout, m_layout);
+    std::swap(dictionary, m_dictionary);
+    if( m_dictionary ) m_layout = m_dictionary.get();
+    std::swap(slots, m_slots);
+    std::swap(scopes, m_scope_chain);
+    std::swap(constants, m_constants);
+
+    native.run(env);
+
+    auto failed = [&](const char* what)
+    {
+        LERROR(LOG_AVM, "native code of block %p differs from interpreter in %s.\n", env.block, what);
+        assert(false);
+    };
+
+    if( expected.status != env.status || expected.next != env.next )
+        return failed("status");
+
+    if( expected.get_current_op() != env.get_current_op() )
+        return failed("depth of stack");
+
+    for( int i=0; i<env.get_current_op(); i++ )
+        if( !is_same(expected.get_operand(i), env.get_operand(i)) )
+            return failed("stack");
+
+    if( !layout->is_equivalent(*m_layout) || slots.size() != m_slots.size() )
+        return failed("properties");
 
-    ScriptObject::mark(v);
+    for( size_t i=0; i<slots.size(); i++ )
+        if( !is_same(slots[i], m_slots[i]) )
+            return failed("properties");
 
-    for( auto scope : m_scope_chain )
+    if( scopes.size() != m_scope_chain.size() || constants != m_constants )
+        return failed("scopes");
+
+    for( size_t i=0; i<scopes.size(); i++ )
     {
-        for( auto pair : scope )
+        if( scopes[i].size() != m_scope_chain[i].size() )
+            return failed("scopes");
+
+        for( auto& pair : scopes[i] )
         {
-            auto object = pair.second.to_object();
-            if( object != nullptr ) object->mark(v);
+            auto found = m_scope_chain[i].find(pair.first);
+            if( found == m_scope_chain[i].end() || !is_same(found->second, pair.second) )
+                return failed("scopes");
         }
     }
+}
+
+void ContextObject::trace(VirtualMachine& vm)
+{
+    ScriptObject::trace(vm);
 
-    for( auto str : m_constants )
-        str->mark(v);
+    for( auto& scope : m_scope_chain )
+    {
+        for( auto& pair : scope )
+            vm.shade(pair.second.to_object());
+    }
 }
 
 std::string ContextObject::to_string() const
@@ -187,102 +301,62 @@ std::string ContextObject::to_string() const
 
 /// STATIC OP HANDLERS
 
+void ContextObject::op_undefined(MovieEnvironment& env)
+{
+    LDEBUG(LOG_AVM, "UNDEFINED OP: %s(0x%X)\n",
+        opcode_to_string(env.record->code), (uint32_t)env.record->code);
+}
+
 void ContextObject::op_constants(MovieEnvironment& env)
 {
-    auto count = env.bytecode->read_uint16();
+    auto first = env.record->operand;
+    auto count = env.record->count;
 
-    env.object->m_constants.clear();
-    for( auto i=0; i<count; i++ )
+    // the atoms are copied, no allocation once the capacity is enough
+    auto& constants = env.object->m_constants;
+    constants.clear();
+    for( uint32_t i=0; i<count; i++ )
     {
-        auto str = env.vm->new_object<StringObject>();
-        str->set(env.bytecode->read_string());
-
-        env.object->m_constants.push_back(str);
-
-#ifdef DEBUG_AVM
-        printf("\t[%d] %s\n", i, env.object->m_constants.back()->c_str());
-#endif
+        constants.push_back(env.block->get_atom(first+i));
+        LTRACE(LOG_AVM, "\t[%d] %s\n", i, constants.back().c_str());
     }
 }
 
-enum class OpPushCode : uint8_t
-{
-    STRING = 0,
-    FLOAT,
-    NIL,
-    UNDEFINED,
-    REGISTER,
-    BOOLEAN,
-    DOUBLE,
-    INTEGER,
-    CONSTANT8,
-    CONSTANT16
-};
-
 void ContextObject::op_push(MovieEnvironment& env)
 {
-    for( auto i=0; !env.is_finished(); i++ )
+    auto first = env.record->operand;
+    auto count = env.record->count;
+
+    for( uint32_t i=0; i<count; i++ )
     {
-        auto type = (OpPushCode)env.bytecode->read_uint8();
-        switch(type)
+        auto& operand = env.block->get_operand(first+i);
+        switch(operand.type)
         {
             case OpPushCode::STRING:
             {
-                auto str = env.vm->new_object<StringObject>();
-                str->set(env.bytecode->read_string());
-
-                env.push(Value().set_object(str));
-                break;
-            }
-
-            case OpPushCode::FLOAT:
-            {
-                env.push(Value().set_number(env.bytecode->read_float32()));
-                break;
-            }
-
-            case OpPushCode::BOOLEAN:
-            {
-                env.push(Value().set_boolean(env.bytecode->read_uint8()));
-                break;
-            }
-
-            case OpPushCode::DOUBLE:
-            {
-                env.push(Value().set_number(env.bytecode->read_float64()));
-                break;
-            }
-
-            case OpPushCode::INTEGER:
-            {
-                env.push(Value().set_integer(env.bytecode->read_uint32()));
+                env.push(Value().set_atom(env.block->get_atom(operand.index)));
                 break;
             }
 
             case OpPushCode::CONSTANT8:
-            {
-                auto index = env.bytecode->read_uint8();
-                env.push(Value().set_object(env.object->m_constants[index]));
-                break;
-            }
-
             case OpPushCode::CONSTANT16:
             {
-                auto index2 = env.bytecode->read_uint16();
-                env.push(Value().set_object(env.object->m_constants[index2]));
+                auto& constants = env.object->m_constants;
+                if( operand.index < constants.size() )
+                    env.push(Value().set_atom(constants[operand.index]));
+                else
+                    env.push(Value());
                 break;
             }
 
             default:
             {
-                env.push(Value());
+                env.push(operand.value);
                 break;
             }
         }
 
-#ifdef DEBUG_AVM
-        printf("\t[%d] %s\n", i, env.back().to_string().c_str());
-#endif
+        LTRACE(LOG_AVM, "\t[%d] %s\n", i, env.back().to_string().c_str());
     }
 }
 
@@ -293,7 +367,8 @@ void ContextObject::op_pop(MovieEnvironment& env)
 
 void ContextObject::op_trace(MovieEnvironment& env)
 {
-    printf("[AVM] trace: %s\n", env.pop().to_string().c_str());
+    auto value = env.pop();
+    LINFO(LOG_AVM, "trace: %s\n", value.to_string().c_str());
 }
 
 void ContextObject::op_next_frame(MovieEnvironment& env)
@@ -309,14 +384,13 @@ void ContextObject::op_prev_frame(MovieEnvironment& env)
 
 void ContextObject::op_goto_frame(MovieEnvironment& env)
 {
-    auto frame = env.bytecode->read_uint16();
-    env.node->goto_frame(frame);
+    env.node->goto_frame(env.record->operand);
 }
 
 void ContextObject::op_goto_label(MovieEnvironment& env)
 {
-    auto name = env.bytecode->read_string();
-    env.node->goto_named_frame(name);
+    auto name = env.block->get_atom(env.record->operand);
+    env.node->goto_named_frame(name.c_str());
 }
 
 void ContextObject::op_play(MovieEnvironment& env)
@@ -9,138 +9,157 @@
 
 NS_AVM_BEGIN
 
-void ContextObject::op_add(MovieEnvironment& env)
+Value ContextObject::evaluate(Opcode code, Value value2, Value value1, int32_t version, AtomTable& atoms)
 {
-    auto op1 = env.pop().to_number();
-    auto op2 = env.pop().to_number();
+    auto op1 = value1.to_number();
+    auto op2 = value2.to_number();
+
+    switch( code )
+    {
+        case Opcode::ADD:
+            return Value().set_number(op1+op2);
+
+        case Opcode::SUBTRACT:
+            return Value().set_number(op2-op1);
+
+        case Opcode::MULTIPLY:
+            return Value().set_number(op2*op1);
+
+        case Opcode::DIVIDE:
+        {
+            if( op1 != 0 )
+                return Value().set_number(op2/op1);
+
+            static auto limit = std::numeric_limits<double>::quiet_NaN();
+            static auto infinity = std::numeric_limits<double>::infinity();
+            if( version < 5 )
+                return Value().set_atom(atoms.intern("#ERROR#"));
+            else if( op2 == 0 || std::isnan(op2) || std::isnan(op1) )
+                return Value().set_number(limit);
+            else
+                return Value().set_number(op2 < 0 ? -infinity : infinity);
+        }
+
+        case Opcode::EQUALS:
+            return version < 5 ?
+                Value().set_number(op2 == op1 ? 1 : 0) : Value().set_boolean(op2 == op1);
+
+        case Opcode::LESS:
+            return version < 5 ?
+                Value().set_number(op2 < op1 ? 1 : 0) : Value().set_boolean(op2 < op1);
 
-    env.push(Value().set_number(op1+op2));
+        case Opcode::GREATER:
+            return version < 5 ?
+                Value().set_number(op2 >= op1 ? 1 : 0) : Value().set_boolean(op2 >= op1);
+
+        case Opcode::AND:
+            return version < 5 ?
+                Value().set_number(op2 != 0 && op1 != 0 ? 1 : 0) : Value().set_boolean(op2 != 0 && op1 != 0);
+
+        case Opcode::OR:
+            return version < 5 ?
+                Value().set_number(op2 != 0 || op1 != 0 ? 1 : 0) : Value().set_boolean(op2 != 0 || op1 != 0);
+
+        case Opcode::NOT:
+            return version < 5 ?
+                Value().set_number(op1 == 0 ? 1 : 0) : Value().set_boolean(op1 == 0);
+
+        default:
+            assert(false);
+            return Value();
+    }
 }
 
-void ContextObject::op_subtract(MovieEnvironment& env)
+void ContextObject::op_add(MovieEnvironment& env)
 {
-    auto op1 = env.pop().to_number();
-    auto op2 = env.pop().to_number();
+    auto op1 = env.pop();
+    auto op2 = env.pop();
+    env.push(evaluate(Opcode::ADD, op2, op1, env.version, env.vm->get_atoms()));
+}
 
-    env.push(Value().set_number(op2-op1));
+void ContextObject::op_subtract(MovieEnvironment& env)
+{
+    auto op1 = env.pop();
+    auto op2 = env.pop();
+    env.push(evaluate(Opcode::SUBTRACT, op2, op1, env.version, env.vm->get_atoms()));
 }
 
 void ContextObject::op_multiply(MovieEnvironment& env)
 {
-    auto op1 = env.pop().to_number();
-    auto op2 = env.pop().to_number();
-
-    env.push(Value().set_number(op2*op1));
+    auto op1 = env.pop();
+    auto op2 = env.pop();
+    env.push(evaluate(Opcode::MULTIPLY, op2, op1, env.version, env.vm->get_atoms()));
 }
 
 void ContextObject::op_divide(MovieEnvironment& env)
 {
-    const static char* err = "#ERROR#";
-
-    auto op1 = env.pop().to_number();
-    auto op2 = env.pop().to_number();
-
-    if( op1 == 0 )
-    {
-        static auto limit = std::numeric_limits<double>::quiet_NaN();
-        static auto infinity = std::numeric_limits<double>::infinity();
-        if( env.version < 5 )
-        {
-            auto str = env.vm->new_object<StringObject>();
-            str->set(err);
-            env.push(Value().set_object(str));
-        }
-        else if( op2 == 0 || std::isnan(op2) || std::isnan(op1) )
-        {
-            env.push(Value().set_number(limit));
-        }
-        else
-        {
-            env.push(Value().set_number(op2 < 0 ? -infinity : infinity));
-        }
-    }
-    else
-        env.push(Value().set_number(op2/op1));
+    auto op1 = env.pop();
+    auto op2 = env.pop();
+    env.push(evaluate(Opcode::DIVIDE, op2, op1, env.version, env.vm->get_atoms()));
 }
 
 void ContextObject::op_equals(MovieEnvironment& env)
 {
-    auto op1 = env.pop().to_number();
-    auto op2 = env.pop().to_number();
-
-    if( env.version < 5 )
-        env.push(Value().set_number(op2 == op1 ? 1 : 0));
-    else
-        env.push(Value().set_boolean(op2 == op1));
+    auto op1 = env.pop();
+    auto op2 = env.pop();
+    env.push(evaluate(Opcode::EQUALS, op2, op1, env.version, env.vm->get_atoms()));
 }
 
 void ContextObject::op_less(MovieEnvironment& env)
 {
-    auto op1 = env.pop().to_number();
-    auto op2 = env.pop().to_number();
-
-    if( env.version < 5 )
-        env.push(Value().set_number(op2 < op1 ? 1 : 0));
-    else
-        env.push(Value().set_boolean(op2 < op1));
+    auto op1 = env.pop();
+    auto op2 = env.pop();
+    env.push(evaluate(Opcode::LESS, op2, op1, env.version, env.vm->get_atoms()));
 }
 
 void ContextObject::op_greater(MovieEnvironment& env)
 {
-    auto op1 = env.pop().to_number();
-    auto op2 = env.pop().to_number();
-
-    if( env.version < 5 )
-        env.push(Value().set_number(op2 >= op1 ? 1 : 0));
-    else
-        env.push(Value().set_boolean(op2 >= op1));
+    auto op1 = env.pop();
+    auto op2 = env.pop();
+    env.push(evaluate(Opcode::GREATER, op2, op1, env.version, env.vm->get_atoms()));
 }
 
 void ContextObject::op_and(MovieEnvironment& env)
 {
-    auto op1 = env.pop().to_number();
-    auto op2 = env.pop().to_number();
-
-    if( env.version < 5 )
-        env.push(Value().set_number(op2 != 0 && op1 != 0 ? 1 : 0));
-    else
-        env.push(Value().set_boolean(op2 != 0 && op1 != 0));
+    auto op1 = env.pop();
+    auto op2 = env.pop();
+    env.push(evaluate(Opcode::AND, op2, op1, env.version, env.vm->get_atoms()));
 }
 
 void ContextObject::op_or(MovieEnvironment& env)
 {
-    auto op1 = env.pop().to_number();
-    auto op2 = env.pop().to_number();
-
-    if( env.version < 5 )
-        env.push(Value().set_number(op2 != 0 || op1 != 0 ? 1 : 0));
-    else
-        env.push(Value().set_boolean(op2 != 0 || op1 != 0));
+    auto op1 = env.pop();
+    auto op2 = env.pop();
+    env.push(evaluate(Opcode::OR, op2, op1, env.version, env.vm->get_atoms()));
 }
 
 void ContextObject::op_not(MovieEnvironment& env)
 {
-    auto op = env.pop().to_number();
-
-    if( env.version < 5 )
-        env.push(Value().set_number(op == 0 ? 1 : 0));
-    else
-        env.push(Value().set_boolean(op == 0));
+    auto op = env.pop();
+    env.push(evaluate(Opcode::NOT, Value(), op, env.version, env.vm->get_atoms()));
 }
 
+// backward branches are where loops are, their bodies are charged against
+// the budget there, and the interpreter stops if its out of budget.
 void ContextObject::op_jump(MovieEnvironment& env)
 {
-    auto offset = env.bytecode->read_int16();
-    auto current = env.bytecode->get_position();
-    env.bytecode->set_position(current+offset);
+    auto target = env.record->operand;
+    if( target < env.next )
+        env.charge(env.next - target);
+    env.next = target;
 }
 
 void ContextObject::op_if(MovieEnvironment& env)
 {
-    auto offset = env.bytecode->read_int16();
-    auto current = env.bytecode->get_position();
     if( env.pop().to_boolean() )
-        env.bytecode->set_position(current+offset);
+        op_jump(env);
+}
+
+// the same as Not followed by If, which jumps if the operand is false
+void ContextObject::op_if_not(MovieEnvironment& env)
+{
+    if( env.pop().to_number() == 0 )
+        op_jump(env);
 }
 
 // void ContextObject::op_call(MovieEnvironment& env)
@@ -8,12 +8,34 @@
 
 NS_AVM_BEGIN
 
+Atom MovieEnvironment::pop_name()
+{
+    auto value = pop();
+    if( value.get_type() == ValueCode::STRING )
+        return value.to_atom();
+    return vm->get_atoms().intern(value.to_string());
+}
+
+bool MovieEnvironment::find_name(Atom& name)
+{
+    auto value = pop();
+    if( value.get_type() == ValueCode::STRING )
+    {
+        name = value.to_atom();
+        return true;
+    }
+
+    auto str = value.to_string();
+    name = vm->get_atoms().find(str.data(), str.size());
+    return !name.empty() || str.empty();
+}
+
 void ContextObject::op_define_local(MovieEnvironment& env)
 {
     auto value  = env.pop();
-    auto name   = env.pop().to_object<StringObject>();
+    auto name   = env.pop_name();
     
-    env.object->set_local_variable(name->c_str(), value);
+    env.object->set_local_variable(name, value);
 }
 
 // sets the variable name in the current execution context to value.
@@ -22,8 +44,8 @@ void ContextObject::op_define_local(MovieEnvironment& env)
 void ContextObject::op_set_variable(MovieEnvironment& env)
 {
     auto value  = env.pop();
-    auto name   = env.pop().to_object<StringObject>();
-    env.object->set_variable(name->c_str(), value);
+    auto name   = env.pop_name();
+    env.object->set_variable(name, value, env.block->get_cache(env.record->operand));
 }
 
 // pushes the value of the variable to the stack.
@@ -31,24 +53,44 @@ void ContextObject::op_set_variable(MovieEnvironment& env)
 // the variable name with the target path and a colon.
 void ContextObject::op_get_variable(MovieEnvironment& env)
 {
-    auto name = env.pop().to_object<StringObject>();
-    assert(name != nullptr);
-    env.push( env.object->get_variable(name->c_str()) );
+    Atom name;
+    if( !env.find_name(name) )
+    {
+        env.push(Value());
+        return;
+    }
+
+    env.push( env.object->get_variable(name, env.block->get_cache(env.record->operand)) );
+}
+
+// the same as pushing the name, which is known by the optimizer of block
+void ContextObject::op_push_get_variable(MovieEnvironment& env)
+{
+    auto name = env.block->get_atom(env.record->count);
+    env.push( env.object->get_variable(name, env.block->get_cache(env.record->operand)) );
 }
 
+// sets the member name of object to value, the member is added if the object
+// does not have it.
 void ContextObject::op_set_member(MovieEnvironment& env)
 {
+    auto value  = env.pop();
+    auto name   = env.pop_name();
+
+    auto object = env.pop().to_object<ScriptObject>();
+    if( object != nullptr )
+        object->set_variable(name, value, env.block->get_cache(env.record->operand));
 }
 
 void ContextObject::op_get_member(MovieEnvironment& env)
 {
-    auto name = env.pop().to_object<StringObject>();
-    assert(name != nullptr);
+    Atom name;
+    auto found = env.find_name(name);
 
     auto object = env.pop().to_object<ScriptObject>();
-    if( object != nullptr )
+    if( found && object != nullptr )
     {
-        env.push( object->get_variable(name->c_str()) );
+        env.push( object->get_variable(name, env.block->get_cache(env.record->operand)) );
         return;
     }
 
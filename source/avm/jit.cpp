@@ -0,0 +1,383 @@
+#include "avm/jit.hpp"
+#include "avm/action_block.hpp"
+#include "avm/context_object.hpp"
+
+#include "debug.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+#if OPENSWF_JIT
+#include <sys/mman.h>
+#endif
+
+NS_AVM_BEGIN
+
+NativeBlock::~NativeBlock()
+{
+#if OPENSWF_JIT
+    if( m_memory != nullptr )
+        munmap(m_memory, m_size);
+#endif
+}
+
+NativeBlockPtr NativeBlock::compile(const ActionBlock& block, const MovieEnvironment& env)
+{
+#if OPENSWF_JIT
+    auto native = new (std::nothrow) NativeBlock();
+    if( native && native->initialize(block, env) )
+        return NativeBlockPtr(native);
+
+    if( native ) delete native;
+#endif
+    return nullptr;
+}
+
+#if OPENSWF_JIT
+
+// the condition of If action, its popped from the stack
+static bool pop_condition(MovieEnvironment& env)
+{
+    return env.pop().to_boolean();
+}
+
+// the condition of fused Not and If
+static bool pop_condition_not(MovieEnvironment& env)
+{
+    return env.pop().to_number() == 0;
+}
+
+// a backward branch charges the loop, the native code returns if its out of
+// budget, and the interpreter resumes it from env.next.
+static bool branch_back(MovieEnvironment& env, uint32_t target, uint32_t span)
+{
+    env.next = target;
+    return env.charge(span);
+}
+
+const static uint64_t TagMask = 0xFFF8000000000000ULL;
+
+enum Condition : uint8_t
+{
+    CC_E    = 0x84,
+    CC_NE   = 0x85,
+    CC_P    = 0x8A,
+    CC_L    = 0x8C,
+    CC_G    = 0x8F,
+};
+
+// emits the few instructions used by compiler, rbx holds the environment,
+// eax the number of operands, and rcx, rdx, r8, r9 and xmm0-1 are scratch.
+class Assembler
+{
+    std::vector<uint8_t>    m_code;
+    int32_t                 m_operands; // offset of operands in environment
+    int32_t                 m_current;  // offset of the number of operands
+
+public:
+    Assembler(int32_t operands, int32_t current)
+    : m_operands(operands), m_current(current) {}
+
+    std::vector<uint8_t>& get_code() { return m_code; }
+    size_t get_position() const { return m_code.size(); }
+
+    void emit(std::initializer_list<uint8_t> bytes)
+    {
+        m_code.insert(m_code.end(), bytes);
+    }
+
+    void emit32(uint32_t v)
+    {
+        for( int i=0; i<4; i++ ) m_code.push_back((v >> (i*8)) & 0xFF);
+    }
+
+    void emit64(uint64_t v)
+    {
+        for( int i=0; i<8; i++ ) m_code.push_back((v >> (i*8)) & 0xFF);
+    }
+
+    // returns the position of rel32 to bind later
+    size_t jump()
+    {
+        emit({0xE9});
+        emit32(0);
+        return get_position() - 4;
+    }
+
+    size_t jump(Condition cc)
+    {
+        emit({0x0F, cc});
+        emit32(0);
+        return get_position() - 4;
+    }
+
+    void bind(size_t patch, size_t target)
+    {
+        auto rel = (int32_t)(target - (patch + 4));
+        memcpy(&m_code[patch], &rel, sizeof(rel));
+    }
+
+    void prologue()         { emit({0x53, 0x48, 0x89, 0xFB}); }         // push rbx; mov rbx, rdi
+    void epilogue()         { emit({0x5B, 0xC3}); }                     // pop rbx; ret
+
+    void load_count()       { emit({0x8B, 0x83}); emit32(m_current); }  // mov eax, [rbx+current]
+    void store_count()      { emit({0x89, 0x83}); emit32(m_current); }  // mov [rbx+current], eax
+    void add_count(int8_t n){ emit({0x83, 0xC0, (uint8_t)n}); }         // add eax, n
+    void compare_count(int32_t n) { emit({0x3D}); emit32(n); }          // cmp eax, n
+
+    // mov rcx/rdx, [rbx+rax*8+operands+index*8]
+    void load_rcx(int32_t index) { emit({0x48, 0x8B, 0x8C, 0xC3}); emit32(m_operands + index*8); }
+    void load_rdx(int32_t index) { emit({0x48, 0x8B, 0x94, 0xC3}); emit32(m_operands + index*8); }
+    // mov [rbx+rax*8+operands+index*8], rdx
+    void store_rdx(int32_t index) { emit({0x48, 0x89, 0x94, 0xC3}); emit32(m_operands + index*8); }
+    // mov dword [rbx+next], v
+    void store_next(int32_t next, uint32_t v) { emit({0xC7, 0x83}); emit32(next); emit32(v); }
+
+    void move_esi(uint32_t v)   { emit({0xBE}); emit32(v); }            // mov esi, imm32
+    void move_edx(uint32_t v)   { emit({0xBA}); emit32(v); }            // mov edx, imm32
+    void move_rdx(uint64_t v)   { emit({0x48, 0xBA}); emit64(v); }      // mov rdx, imm64
+    void move_r8(uint64_t v)    { emit({0x49, 0xB8}); emit64(v); }      // mov r8, imm64
+
+    // jumps to the returned patch if the value of register is not a number,
+    // which is tagged if all the bits of TagMask in r8 are set.
+    size_t jump_if_tagged(bool rdx)
+    {
+        emit({0x49, 0x89, (uint8_t)(rdx ? 0xD1 : 0xC9)});   // mov r9, rdx/rcx
+        emit({0x4D, 0x21, 0xC1});                           // and r9, r8
+        emit({0x4D, 0x39, 0xC1});                           // cmp r9, r8
+        return jump(CC_E);
+    }
+
+    void call(const void* function)
+    {
+        emit({0x48, 0x89, 0xDF});                           // mov rdi, rbx
+        emit({0x48, 0xB8});                                 // mov rax, imm64
+        emit64((uint64_t)(uintptr_t)function);
+        emit({0xFF, 0xD0});                                 // call rax
+    }
+
+    // env.record = record, then calls the handler
+    void call_handler(int32_t record_offset, const ActionRecord& record)
+    {
+        emit({0x48, 0xB8});                                 // mov rax, imm64
+        emit64((uint64_t)(uintptr_t)&record);
+        emit({0x48, 0x89, 0x83});                           // mov [rbx+record], rax
+        emit32(record_offset);
+        call((const void*)record.handler);
+    }
+};
+
+static uint64_t to_bits(const Value& value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+bool NativeBlock::initialize(const ActionBlock& block, const MovieEnvironment& env)
+{
+    auto base = reinterpret_cast<const char*>(&env);
+    auto operands = (int32_t)(reinterpret_cast<const char*>(&env.m_operands[0]) - base);
+    auto current = (int32_t)(reinterpret_cast<const char*>(&env.m_current_operand) - base);
+    auto record_offset = (int32_t)(reinterpret_cast<const char*>(&env.record) - base);
+    auto next_offset = (int32_t)(reinterpret_cast<const char*>(&env.next) - base);
+
+    static_assert( sizeof(Value) == 8, "operands are addressed by a scale of 8." );
+
+    Assembler a(operands, current);
+    std::vector<size_t> labels;
+    std::vector<std::pair<size_t, uint32_t>> branches;
+    std::vector<size_t> exits;
+
+    a.prologue();
+
+    auto count = block.get_record_count();
+
+    // loops return to the interpreter once they are out of budget
+    auto loop = [&](uint32_t target, uint32_t span)
+    {
+        a.move_esi(target);
+        a.move_edx(span);
+        a.call((const void*)branch_back);
+        a.emit({0x84, 0xC0});                               // test al, al
+        branches.push_back(std::make_pair(a.jump(CC_NE), target));
+        exits.push_back(a.jump());
+    };
+
+    for( uint32_t i=0; i<count; i++ )
+    {
+        labels.push_back(a.get_position());
+
+        auto& record = block.get_record(i);
+        std::vector<size_t> slow;
+
+        switch( record.code )
+        {
+            case Opcode::PUSH:
+            {
+                // literals and strings are known now, constants are not
+                std::vector<uint64_t> values;
+                for( uint32_t k=0; k<record.count; k++ )
+                {
+                    auto& operand = block.get_operand(record.operand+k);
+                    if( operand.type == OpPushCode::CONSTANT8 || operand.type == OpPushCode::CONSTANT16 )
+                        break;
+
+                    values.push_back( operand.type == OpPushCode::STRING ?
+                        to_bits(Value().set_atom(block.get_atom(operand.index))) :
+                        to_bits(operand.value) );
+                }
+
+                if( values.size() != record.count || record.count == 0 || record.count > MaxOperands )
+                {
+                    a.call_handler(record_offset, record);
+                    continue;
+                }
+
+                a.load_count();
+                a.compare_count(MaxOperands - record.count);
+                slow.push_back(a.jump(CC_G));
+                for( uint32_t k=0; k<values.size(); k++ )
+                {
+                    a.move_rdx(values[k]);
+                    a.store_rdx(k);
+                }
+                a.add_count(record.count);
+                a.store_count();
+                break;
+            }
+
+            case Opcode::POP:
+            {
+                a.load_count();
+                a.compare_count(0);
+                slow.push_back(a.jump(CC_E));
+                a.add_count(-1);
+                a.store_count();
+                break;
+            }
+
+            case Opcode::ADD:
+            case Opcode::SUBTRACT:
+            case Opcode::MULTIPLY:
+            {
+                a.load_count();
+                a.compare_count(2);
+                slow.push_back(a.jump(CC_L));
+                a.load_rcx(-1);
+                a.load_rdx(-2);
+                a.move_r8(TagMask);
+                slow.push_back(a.jump_if_tagged(false));
+                slow.push_back(a.jump_if_tagged(true));
+
+                a.emit({0x66, 0x48, 0x0F, 0x6E, 0xC2});     // movq xmm0, rdx
+                a.emit({0x66, 0x48, 0x0F, 0x6E, 0xC9});     // movq xmm1, rcx
+                if( record.code == Opcode::ADD )
+                    a.emit({0xF2, 0x0F, 0x58, 0xC1});       // addsd xmm0, xmm1
+                else if( record.code == Opcode::SUBTRACT )
+                    a.emit({0xF2, 0x0F, 0x5C, 0xC1});       // subsd xmm0, xmm1
+                else
+                    a.emit({0xF2, 0x0F, 0x59, 0xC1});       // mulsd xmm0, xmm1
+
+                // nans are canonicalized by the handler
+                a.emit({0x66, 0x0F, 0x2E, 0xC0});           // ucomisd xmm0, xmm0
+                slow.push_back(a.jump(CC_P));
+                a.emit({0x66, 0x48, 0x0F, 0x7E, 0xC2});     // movq rdx, xmm0
+                a.store_rdx(-2);
+                a.add_count(-1);
+                a.store_count();
+                break;
+            }
+
+            case Opcode::JUMP:
+            {
+                if( record.operand <= i )
+                {
+                    loop(record.operand, i + 1 - record.operand);
+                    continue;
+                }
+
+                branches.push_back(std::make_pair(a.jump(), record.operand));
+                continue;
+            }
+
+            case Opcode::IF:
+            case Opcode::IF_NOT:
+            {
+                a.call(record.code == Opcode::IF ? (const void*)pop_condition : (const void*)pop_condition_not);
+                a.emit({0x84, 0xC0});                       // test al, al
+                if( record.operand <= i )
+                {
+                    auto skip = a.jump(CC_E);
+                    loop(record.operand, i + 1 - record.operand);
+                    a.bind(skip, a.get_position());
+                    continue;
+                }
+
+                branches.push_back(std::make_pair(a.jump(CC_NE), record.operand));
+                continue;
+            }
+
+            default:
+            {
+                a.call_handler(record_offset, record);
+                continue;
+            }
+        }
+
+        // the handler takes the cases which are not inlined
+        auto done = a.jump();
+        for( auto patch : slow )
+            a.bind(patch, a.get_position());
+        a.call_handler(record_offset, record);
+        a.bind(done, a.get_position());
+    }
+
+    // the same as interpreter, a finished block is left at its end
+    labels.push_back(a.get_position());
+    a.store_next(next_offset, count);
+
+    auto exit = a.get_position();
+    a.epilogue();
+
+    for( auto& branch : branches )
+        a.bind(branch.first, labels[std::min(branch.second, count)]);
+
+    for( auto patch : exits )
+        a.bind(patch, exit);
+
+    auto& code = a.get_code();
+    auto memory = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if( memory == MAP_FAILED )
+    {
+        LWARNING(LOG_AVM, "failed to map %d bytes of native code.\n", (int)code.size());
+        return false;
+    }
+
+    memcpy(memory, code.data(), code.size());
+    if( mprotect(memory, code.size(), PROT_READ | PROT_EXEC) != 0 )
+    {
+        munmap(memory, code.size());
+        return false;
+    }
+
+    m_memory = memory;
+    m_size = code.size();
+    m_entry = reinterpret_cast<Entry>(memory);
+
+    LDEBUG(LOG_AVM, "compiled %d actions into %d bytes of native code.\n", count, (int)m_size);
+    return true;
+}
+
+#else
+
+bool NativeBlock::initialize(const ActionBlock&, const MovieEnvironment&)
+{
+    return false;
+}
+
+#endif
+
+NS_AVM_END
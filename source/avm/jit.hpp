@@ -0,0 +1,73 @@
+#pragma once
+
+#include "avm/avm.hpp"
+
+#include <memory>
+
+// the baseline compiler emits x86-64 code of the system v calling convention,
+// define OPENSWF_JIT as 0 to leave it out.
+#if !defined(OPENSWF_JIT)
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define OPENSWF_JIT 1
+#else
+#define OPENSWF_JIT 0
+#endif
+#endif
+
+NS_AVM_BEGIN
+
+struct MovieEnvironment;
+
+enum class JitMode : uint8_t
+{
+    // every block is interpreted
+    DISABLED = 0,
+    // blocks are compiled into native code once they are hot
+    ENABLED,
+    // hot blocks are both interpreted and run natively, and the stacks and
+    // variables of the two are compared. actions on timeline run twice.
+    DIFFERENTIAL
+};
+
+class NativeBlock;
+typedef std::unique_ptr<NativeBlock> NativeBlockPtr;
+
+// the native code of a hot action block. the operand stack is kept in the
+// environment, pushes of literals, pops, arithmetic on numbers and branches
+// are inlined, and the other actions call their handlers.
+class NativeBlock
+{
+    typedef void (*Entry)(MovieEnvironment&);
+
+protected:
+    void*   m_memory;
+    size_t  m_size;
+    Entry   m_entry;
+
+public:
+    // returns nullptr if native code is not supported on this platform. the
+    // environment gives the layout of operand stack only.
+    static NativeBlockPtr compile(const ActionBlock& block, const MovieEnvironment& env);
+
+    NativeBlock() : m_memory(nullptr), m_size(0), m_entry(nullptr) {}
+    ~NativeBlock();
+
+    void    run(MovieEnvironment& env) const;
+    size_t  get_size() const;
+
+protected:
+    bool initialize(const ActionBlock& block, const MovieEnvironment& env);
+};
+
+// INLINE METHODS
+inline void NativeBlock::run(MovieEnvironment& env) const
+{
+    m_entry(env);
+}
+
+inline size_t NativeBlock::get_size() const
+{
+    return m_size;
+}
+
+NS_AVM_END
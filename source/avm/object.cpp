@@ -1,15 +1,19 @@
 #include "object.hpp"
+#include "virtual_machine.hpp"
 
 NS_AVM_BEGIN
 
-void GCObject::mark(uint8_t v)
-{
-    m_marked = v;
-}
+void GCObject::trace(VirtualMachine&)
+{}
 
 std::string GCObject::to_string() const
 {
     return "[type GCObject]";
 }
 
-NS_AVM_END
\ No newline at end of file
+void GCObject::write_barrier_slow(GCObject* child)
+{
+    m_vm->write_barrier(this, child);
+}
+
+NS_AVM_END
@@ -6,20 +6,56 @@
 
 NS_AVM_BEGIN
 
+// the tri-color of incremental marking. white objects are not reached yet,
+// gray ones are reached but their references are not traced, and black ones
+// are done. a black object never refers to a white one while marking.
+enum class GCColor : uint8_t
+{
+    WHITE = 0,
+    GRAY,
+    BLACK
+};
+
 class GCObject
 {
     friend class VirtualMachine;
 
 private:
-    uint8_t     m_marked;
-    GCObject*   m_next;
+    GCColor         m_color;
+    bool            m_old;          // survived a collection, promoted out of nursery
+    bool            m_remembered;   // in the remembered set, or always scanned
+    GCObject*       m_next;
+    VirtualMachine* m_vm;           // the collector, or nullptr if not managed
 
 public:
-    GCObject() : m_marked(0), m_next(nullptr) {}
+    GCObject() : m_color(GCColor::WHITE), m_old(false), m_remembered(false),
+        m_next(nullptr), m_vm(nullptr) {}
+    virtual ~GCObject() {}
 
-    uint8_t get_marked_value() const { return m_marked; }
-    virtual void mark(uint8_t v);
+    GCColor get_color() const { return m_color; }
+    bool    is_old() const { return m_old; }
+
+    // shades the objects referred by this one, see VirtualMachine::shade.
+    virtual void trace(VirtualMachine&);
     virtual std::string to_string() const;
+
+protected:
+    // must be called whenever a reference to child is stored into this object.
+    void    write_barrier(GCObject* child);
+
+private:
+    void    write_barrier_slow(GCObject* child);
 };
 
-NS_AVM_END
\ No newline at end of file
+// INLINE METHODS
+inline void GCObject::write_barrier(GCObject* child)
+{
+    if( m_vm == nullptr || child == nullptr )
+        return;
+
+    if( (m_color == GCColor::BLACK && child->m_color == GCColor::WHITE) ||
+        (m_old && !m_remembered && !child->m_old) )
+        write_barrier_slow(child);
+}
+
+NS_AVM_END
@@ -0,0 +1,86 @@
+#include "avm/object_layout.hpp"
+
+NS_AVM_BEGIN
+
+// the limits of tree, objects beyond them are dictionaries
+const static uint32_t MaxLayoutSlots = 64;
+const static uint32_t MaxTreeSize = 4096;
+
+ObjectLayout::ObjectLayout()
+: m_root(this), m_slots(std::make_shared<Slots>()), m_slot_count(0), m_dictionary(false)
+{}
+
+ObjectLayout::ObjectLayout(ObjectLayout* parent, Atom name)
+: m_root(parent->m_root), m_slot_count(parent->m_slot_count+1), m_dictionary(false)
+{
+    // the last layout of a chain extends its table, others copy the names
+    if( parent->m_slots->size() == parent->m_slot_count )
+        m_slots = parent->m_slots;
+    else
+    {
+        m_slots = std::make_shared<Slots>();
+        for( auto& pair : *parent->m_slots )
+        {
+            if( pair.second < parent->m_slot_count )
+                m_slots->insert(pair);
+        }
+    }
+
+    (*m_slots)[name] = parent->m_slot_count;
+}
+
+ObjectLayout* ObjectLayout::add(Atom name)
+{
+    assert( find(name) < 0 );
+
+    if( m_dictionary )
+    {
+        (*m_slots)[name] = m_slot_count++;
+        return this;
+    }
+
+    auto found = m_transitions.find(name);
+    if( found != m_transitions.end() )
+        return found->second;
+
+    if( m_slot_count >= MaxLayoutSlots || get_tree_size() >= MaxTreeSize )
+        return nullptr;
+
+    auto layout = new ObjectLayout(this, name);
+    m_root->m_layouts.push_back(ObjectLayoutPtr(layout));
+    m_transitions[name] = layout;
+    return layout;
+}
+
+ObjectLayoutPtr ObjectLayout::to_dictionary() const
+{
+    auto dictionary = new ObjectLayout();
+    dictionary->m_slot_count = m_slot_count;
+    dictionary->m_dictionary = true;
+    for( auto& pair : *m_slots )
+    {
+        if( pair.second < m_slot_count )
+            dictionary->m_slots->insert(pair);
+    }
+
+    return ObjectLayoutPtr(dictionary);
+}
+
+bool ObjectLayout::is_equivalent(const ObjectLayout& other) const
+{
+    if( this == &other )
+        return true;
+
+    if( m_slot_count != other.m_slot_count )
+        return false;
+
+    for( auto& pair : *m_slots )
+    {
+        if( pair.second < m_slot_count && other.find(pair.first) != (int32_t)pair.second )
+            return false;
+    }
+
+    return true;
+}
+
+NS_AVM_END
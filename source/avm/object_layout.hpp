@@ -0,0 +1,102 @@
+#pragma once
+
+#include "avm/avm.hpp"
+#include "atom.hpp"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+NS_AVM_BEGIN
+
+class ObjectLayout;
+typedef std::unique_ptr<ObjectLayout> ObjectLayoutPtr;
+
+// the hidden class of script objects, objects which have the same properties
+// added in the same order share a layout, and keep their values in slots of
+// the order. layouts form a tree of transitions from an empty root, the root
+// owns all the layouts of its tree and frees them together.
+//
+// the layouts along a chain of transitions share one table of names, a
+// layout has the names of the slots before its count, so a name is found by
+// one lookup. a layout branching off the middle of a chain copies its names.
+//
+// the tree is bounded, an object with too many properties, or adding one
+// once the tree is full, moves into a dictionary of its own, which is changed
+// in place and never cached.
+class ObjectLayout
+{
+    typedef std::unordered_map<Atom, uint32_t> Slots;
+    typedef std::unordered_map<Atom, ObjectLayout*> Transitions;
+    typedef std::vector<ObjectLayoutPtr> Layouts;
+
+protected:
+    ObjectLayout*           m_root;
+    std::shared_ptr<Slots>  m_slots;        // the table of chain
+    uint32_t                m_slot_count;
+    bool                    m_dictionary;
+    Transitions             m_transitions;
+    Layouts                 m_layouts;      // the tree owned by root
+
+public:
+    // creates an empty root layout
+    ObjectLayout();
+
+    // returns the slot of property, or -1 if there is no such property.
+    int32_t         find(Atom name) const;
+    // returns the layout with the property appended, its shared by all the
+    // objects adding the same property to this layout. a dictionary appends
+    // it in place. returns nullptr if the tree has no room for it.
+    ObjectLayout*   add(Atom name);
+    // returns a dictionary with the same properties, owned by the caller.
+    ObjectLayoutPtr to_dictionary() const;
+    // layouts are equivalent if they have the same names in the same slots.
+    bool            is_equivalent(const ObjectLayout& other) const;
+
+    bool            is_dictionary() const;
+    uint32_t        get_slot_count() const;
+    // the number of layouts in the tree, including the root.
+    uint32_t        get_tree_size() const;
+
+protected:
+    ObjectLayout(ObjectLayout* parent, Atom name);
+};
+
+// a monomorphic inline cache of a property access site, it remembers the
+// slot of the name in the layout which has been seen last time, or the
+// transition if the property was added by a assignment.
+struct PropertyCache
+{
+    const ObjectLayout* layout;
+    ObjectLayout*       transition;
+    Atom                name;
+    uint32_t            slot;
+
+    PropertyCache() : layout(nullptr), transition(nullptr), slot(0) {}
+};
+
+// INLINE METHODS
+inline int32_t ObjectLayout::find(Atom name) const
+{
+    auto found = m_slots->find(name);
+    if( found == m_slots->end() || found->second >= m_slot_count )
+        return -1;
+    return (int32_t)found->second;
+}
+
+inline bool ObjectLayout::is_dictionary() const
+{
+    return m_dictionary;
+}
+
+inline uint32_t ObjectLayout::get_slot_count() const
+{
+    return m_slot_count;
+}
+
+inline uint32_t ObjectLayout::get_tree_size() const
+{
+    return m_root->m_layouts.size() + 1;
+}
+
+NS_AVM_END
@@ -65,6 +65,9 @@ const char* opcode_to_string(Opcode code)
 
     case Opcode::CONSTANT_POOL      : return "CONSTANT_POOL   ";
     case Opcode::DEFINE_LOCAL       : return "DEFINE_LOCAL    ";
+
+    case Opcode::IF_NOT             : return "IF_NOT          ";
+    case Opcode::PUSH_GET_VARIABLE  : return "PUSH_GET_VARIABLE";
     default: return "UNDEFINED       ";
     }
 }
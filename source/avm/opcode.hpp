@@ -43,6 +43,11 @@ enum class Opcode : uint8_t
 
 
     CONSTANT_POOL   = 0x88,
+
+    // superinstructions fused by the optimizer of ActionBlock, their codes
+    // are not used by swf.
+    IF_NOT              = 0x01, // Not, If
+    PUSH_GET_VARIABLE   = 0x02, // Push of a name, GetVariable
 };
 
 const char* opcode_to_string(Opcode);
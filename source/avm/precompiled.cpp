@@ -0,0 +1,54 @@
+#include "avm/precompiled.hpp"
+
+#include <cstring>
+
+NS_AVM_BEGIN
+
+PrecompiledRegistry& PrecompiledRegistry::get_instance()
+{
+    static PrecompiledRegistry s_instance;
+    return s_instance;
+}
+
+uint64_t PrecompiledRegistry::hash(const uint8_t* bytes, uint32_t size)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for( uint32_t i=0; i<size; i++ )
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void PrecompiledRegistry::add(const PrecompiledEntry* entries, uint32_t count)
+{
+    for( uint32_t i=0; i<count; i++ )
+        m_entries[entries[i].hash] = entries[i];
+}
+
+void PrecompiledRegistry::remove(const PrecompiledEntry* entries, uint32_t count)
+{
+    for( uint32_t i=0; i<count; i++ )
+    {
+        auto found = m_entries.find(entries[i].hash);
+        if( found != m_entries.end() && found->second.function == entries[i].function )
+            m_entries.erase(found);
+    }
+}
+
+PrecompiledActions PrecompiledRegistry::find(const uint8_t* bytes, uint32_t size) const
+{
+    if( m_entries.empty() )
+        return nullptr;
+
+    auto found = m_entries.find(hash(bytes, size));
+    if( found == m_entries.end() || found->second.size != size )
+        return nullptr;
+
+    if( memcmp(found->second.bytes, bytes, size) != 0 )
+        return nullptr;
+    return found->second.function;
+}
+
+NS_AVM_END
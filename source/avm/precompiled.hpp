@@ -0,0 +1,70 @@
+#pragma once
+
+#include "avm/avm.hpp"
+
+#include <unordered_map>
+
+NS_AVM_BEGIN
+
+struct MovieEnvironment;
+typedef void (*PrecompiledActions)(MovieEnvironment&);
+
+struct PrecompiledEntry
+{
+    uint64_t            hash;   // of the bytecode, see PrecompiledRegistry::hash
+    uint32_t            size;   // in bytes of the bytecode
+    const uint8_t*      bytes;  // the bytecode, compared once the hash matches
+    PrecompiledActions  function;
+};
+
+// the c++ functions translated from the action blocks of shipped movies by
+// the action compiler ahead of time. generated sources register their tables
+// at static initialization, and blocks of the same bytecode run them instead
+// of being interpreted.
+class PrecompiledRegistry
+{
+    typedef std::unordered_map<uint64_t, PrecompiledEntry> Entries;
+
+protected:
+    Entries m_entries;
+
+public:
+    static PrecompiledRegistry& get_instance();
+    // 64-bit FNV-1a of the bytecode, together with its size
+    static uint64_t hash(const uint8_t* bytes, uint32_t size);
+
+    void                add(const PrecompiledEntry* entries, uint32_t count);
+    // entries replaced by other tables are kept
+    void                remove(const PrecompiledEntry* entries, uint32_t count);
+    // returns nullptr if the bytecode is not precompiled, the bytes are
+    // compared so blocks of colliding hashes are never mixed up
+    PrecompiledActions  find(const uint8_t* bytes, uint32_t size) const;
+    bool                empty() const;
+};
+
+// a static instance in generated sources registers their table, and its
+// removed once the registrar is destroyed
+struct PrecompiledRegistrar
+{
+    const PrecompiledEntry* entries;
+    uint32_t                count;
+
+    PrecompiledRegistrar(const PrecompiledEntry* entries, uint32_t count)
+    : entries(entries), count(count)
+    {
+        PrecompiledRegistry::get_instance().add(entries, count);
+    }
+
+    ~PrecompiledRegistrar()
+    {
+        PrecompiledRegistry::get_instance().remove(entries, count);
+    }
+};
+
+// INLINE METHODS
+inline bool PrecompiledRegistry::empty() const
+{
+    return m_entries.empty();
+}
+
+NS_AVM_END
@@ -1,34 +1,110 @@
 #include "avm/script_object.hpp"
 #include "avm/string_object.hpp"
+#include "avm/virtual_machine.hpp"
 
 NS_AVM_BEGIN
 
-void ScriptObject::mark(uint8_t v)
+ScriptObject::ScriptObject(ObjectLayout* root)
+: m_layout(root)
+{}
+
+void ScriptObject::trace(VirtualMachine& vm)
+{
+    for( auto& value : m_slots )
+        vm.shade(value.to_object());
+}
+
+void ScriptObject::set_variable(Atom name, Value value)
+{
+    write_barrier(value.to_object());
+
+    auto slot = m_layout->find(name);
+    if( slot >= 0 )
+    {
+        m_slots[slot] = value;
+        return;
+    }
+
+    append(name, value);
+}
+
+Value ScriptObject::get_variable(Atom name)
+{
+    auto slot = m_layout->find(name);
+    if( slot >= 0 )
+        return m_slots[slot];
+    return Value();
+}
+
+void ScriptObject::set_variable(Atom name, Value value, PropertyCache& cache)
 {
-    if( get_marked_value() != 0 )
+    write_barrier(value.to_object());
+
+    if( cache.layout == m_layout && cache.name == name )
+    {
+        if( cache.transition != nullptr )
+        {
+            m_layout = cache.transition;
+            m_slots.push_back(value);
+        }
+        else
+            m_slots[cache.slot] = value;
         return;
+    }
 
-    GCObject::mark(v);
+    auto layout = m_layout;
+    auto slot = m_layout->find(name);
+    if( slot >= 0 )
+        m_slots[slot] = value;
+    else
+        append(name, value);
 
-    for( auto pair : m_variables )
+    // dictionaries are changed in place, so they are never cached
+    if( m_layout->is_dictionary() )
     {
-        auto object = pair.second.to_object();
-        if( object != nullptr ) object->mark(v);
+        cache.layout = nullptr;
+        return;
     }
+
+    cache.layout = layout;
+    cache.name = name;
+    cache.transition = slot >= 0 ? nullptr : m_layout;
+    cache.slot = slot >= 0 ? slot : m_slots.size()-1;
 }
 
-void ScriptObject::set_variable(const char* name, Value value)
+Value ScriptObject::get_variable(Atom name, PropertyCache& cache)
 {
-    // printf("set variable %s -> %s\n", name, value.to_string().c_str());
-    m_variables[name] = value;
+    if( cache.layout == m_layout && cache.name == name && cache.transition == nullptr )
+        return m_slots[cache.slot];
+
+    auto slot = m_layout->find(name);
+    if( slot < 0 )
+        return Value();
+
+    if( !m_layout->is_dictionary() )
+    {
+        cache.layout = m_layout;
+        cache.transition = nullptr;
+        cache.name = name;
+        cache.slot = slot;
+    }
+
+    return m_slots[slot];
 }
 
-Value ScriptObject::get_variable(const char* name)
+// an object leaves the tree of layouts for a dictionary of its own, once
+// the tree has no room for its properties.
+void ScriptObject::append(Atom name, Value value)
 {
-    auto found = m_variables.find(name);
-    if( found != m_variables.end() )
-        return found->second;
-    return Value();
+    auto layout = m_layout->add(name);
+    if( layout == nullptr )
+    {
+        m_dictionary = m_layout->to_dictionary();
+        layout = m_dictionary->add(name);
+    }
+
+    m_layout = layout;
+    m_slots.push_back(value);
 }
 
-NS_AVM_END
\ No newline at end of file
+NS_AVM_END
@@ -2,22 +2,43 @@
 
 #include "avm/avm.hpp"
 #include "avm/object.hpp"
+#include "avm/object_layout.hpp"
 #include "avm/value.hpp"
 
-#include <unordered_map>
-#include <string>
+#include <vector>
 
 NS_AVM_BEGIN
 
 class ScriptObject : public GCObject
 {
 protected:
-    std::unordered_map<std::string, Value> m_variables;
+    ObjectLayout*       m_layout;
+    ObjectLayoutPtr     m_dictionary;   // the layout once out of tree
+    std::vector<Value>  m_slots;        // values of properties in the layout
 
 public:
-    virtual void    mark(uint8_t);
-    virtual void    set_variable(const char*, Value);
-    virtual Value   get_variable(const char*);
+    // objects start from the empty layout of virtual machine.
+    explicit ScriptObject(ObjectLayout* root);
+
+    virtual void    trace(VirtualMachine&);
+    virtual void    set_variable(Atom, Value);
+    virtual Value   get_variable(Atom);
+
+    // the accesses of a site, which the cache belongs to, skip looking up
+    // the name if the layout is the same as last time.
+    virtual void    set_variable(Atom, Value, PropertyCache&);
+    virtual Value   get_variable(Atom, PropertyCache&);
+
+    const ObjectLayout* get_layout() const;
+
+protected:
+    void            append(Atom, Value);
 };
 
-NS_AVM_END
\ No newline at end of file
+// INLINE METHODS
+inline const ObjectLayout* ScriptObject::get_layout() const
+{
+    return m_layout;
+}
+
+NS_AVM_END
@@ -0,0 +1,158 @@
+#include "avm/script_profiler.hpp"
+#include "avm/action_block.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+NS_AVM_BEGIN
+
+static std::string format(const char* fmt, ...)
+{
+    char buffer[256];
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+
+    return buffer;
+}
+
+ScriptProfiler::ScriptProfiler()
+{
+    reset();
+}
+
+uint64_t ScriptProfiler::now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void ScriptProfiler::add_block(const ActionBlock& block, bool call, uint64_t cycles)
+{
+    auto found = m_blocks.find(&block);
+    if( found == m_blocks.end() )
+    {
+        BlockCost cost;
+        cost.block = &block;
+        cost.character_id = block.get_character_id();
+        cost.frame = block.get_frame();
+        cost.records = block.get_record_count();
+        cost.calls = 0;
+        cost.cycles = 0;
+        found = m_blocks.insert(std::make_pair(&block, cost)).first;
+    }
+
+    if( call ) found->second.calls ++;
+    found->second.cycles += cycles;
+}
+
+void ScriptProfiler::reset()
+{
+    for( auto i=0; i<256; i++ )
+    {
+        m_opcodes[i].code = (Opcode)i;
+        m_opcodes[i].count = 0;
+        m_opcodes[i].cycles = 0;
+    }
+
+    m_blocks.clear();
+}
+
+ScriptReport ScriptProfiler::get_report() const
+{
+    ScriptReport report;
+
+    for( auto& cost : m_opcodes )
+    {
+        if( cost.count > 0 )
+            report.opcodes.push_back(cost);
+    }
+
+    report.blocks.reserve(m_blocks.size());
+    for( auto& pair : m_blocks )
+        report.blocks.push_back(pair.second);
+
+    // ties are ordered by code, and by where blocks are defined
+    std::sort(report.opcodes.begin(), report.opcodes.end(),
+        [](const OpcodeCost& a, const OpcodeCost& b)
+        {
+            if( a.cycles != b.cycles ) return a.cycles > b.cycles;
+            return a.code < b.code;
+        });
+
+    std::sort(report.blocks.begin(), report.blocks.end(),
+        [](const BlockCost& a, const BlockCost& b)
+        {
+            if( a.cycles != b.cycles ) return a.cycles > b.cycles;
+            if( a.character_id != b.character_id ) return a.character_id < b.character_id;
+            return a.frame < b.frame;
+        });
+
+    return report;
+}
+
+std::string ScriptReport::to_string() const
+{
+    std::string text;
+
+    text += "character  frame  records        calls       cycles  cycles/call\n";
+    for( auto& cost : blocks )
+    {
+        text += format("%9d  %5d  %7d  %11" PRIu64 "  %11" PRIu64 "  %11" PRIu64 "\n",
+            cost.character_id, cost.frame, cost.records, cost.calls, cost.cycles,
+            cost.calls > 0 ? cost.cycles / cost.calls : 0);
+    }
+
+    text += "\nopcode                  count       cycles  cycles/count\n";
+    for( auto& cost : opcodes )
+    {
+        text += format("%s  %11" PRIu64 "  %11" PRIu64 "  %12" PRIu64 "\n",
+            opcode_to_string(cost.code), cost.count, cost.cycles, cost.cycles / cost.count);
+    }
+
+    return text;
+}
+
+std::string ScriptReport::to_json() const
+{
+    std::string json = "{\n  \"blocks\": [";
+    for( size_t i=0; i<blocks.size(); i++ )
+    {
+        auto& cost = blocks[i];
+        json += i > 0 ? ",\n    " : "\n    ";
+        json += format("{ \"character_id\": %d, \"frame\": %d, \"records\": %d, "
+            "\"calls\": %" PRIu64 ", \"cycles\": %" PRIu64 " }",
+            cost.character_id, cost.frame, cost.records, cost.calls, cost.cycles);
+    }
+
+    json += blocks.empty() ? "],\n  \"opcodes\": [" : "\n  ],\n  \"opcodes\": [";
+    for( size_t i=0; i<opcodes.size(); i++ )
+    {
+        auto& cost = opcodes[i];
+        std::string name = opcode_to_string(cost.code);
+        name.erase(name.find_last_not_of(' ')+1);
+
+        json += i > 0 ? ",\n    " : "\n    ";
+        json += format("{ \"opcode\": \"%s\", \"code\": %d, "
+            "\"count\": %" PRIu64 ", \"cycles\": %" PRIu64 " }",
+            name.c_str(), (int)cost.code, cost.count, cost.cycles);
+    }
+
+    json += opcodes.empty() ? "]\n}\n" : "\n  ]\n}\n";
+    return json;
+}
+
+NS_AVM_END
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "avm/avm.hpp"
+#include "avm/opcode.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+NS_AVM_BEGIN
+
+class ActionBlock;
+
+struct OpcodeCost
+{
+    Opcode      code;
+    uint64_t    count;
+    uint64_t    cycles;     // of handlers, including blocks executed by them
+};
+
+struct BlockCost
+{
+    const ActionBlock*  block;
+    uint16_t            character_id;   // of the movie clip defining it
+    uint16_t            frame;          // index of the frame in movie clip
+    uint32_t            records;
+    uint64_t            calls;          // a resumed block is counted once
+    uint64_t            cycles;         // inclusive, summed over resumptions
+};
+
+struct ScriptReport
+{
+    std::vector<OpcodeCost> opcodes;    // the most expensive first
+    std::vector<BlockCost>  blocks;     // the most expensive first
+
+    // a table of blocks and opcodes for logging
+    std::string to_string() const;
+    std::string to_json() const;
+};
+
+// records the cost of every action executed and every block run by a
+// virtual machine with profiling enabled. cycles are ticks of time stamp
+// counter on x86, or nanoseconds elsewhere. blocks are interpreted while
+// profiling, so the native and precompiled code are not measured.
+class ScriptProfiler
+{
+    typedef std::unordered_map<const ActionBlock*, BlockCost> Blocks;
+
+protected:
+    OpcodeCost      m_opcodes[256];
+    Blocks          m_blocks;
+
+public:
+    ScriptProfiler();
+
+    static uint64_t now();
+
+    void            add_action(Opcode code, uint64_t cycles);
+    void            add_block(const ActionBlock& block, bool call, uint64_t cycles);
+    void            reset();
+
+    ScriptReport    get_report() const;
+};
+
+// INLINE METHODS
+inline void ScriptProfiler::add_action(Opcode code, uint64_t cycles)
+{
+    auto& cost = m_opcodes[(uint8_t)code];
+    cost.count ++;
+    cost.cycles += cycles;
+}
+
+NS_AVM_END
@@ -7,7 +7,7 @@ NS_AVM_BEGIN
 
 std::string Value::to_string() const
 {
-    switch(this->type)
+    switch(get_type())
     {
         case ValueCode::UNDEFINED:
             return "undefined";
@@ -18,22 +18,25 @@ std::string Value::to_string() const
         case ValueCode::NUMBER:
         {
             std::stringstream s;
-            s << this->inner.d;
+            s << to_number();
             return s.str();
         }
 
         case ValueCode::INTEGER:
         {
             std::stringstream s;
-            s << this->inner.i;
+            s << (int32_t)get_payload();
             return s.str();
         }
 
         case ValueCode::BOOLEAN:
-            return this->inner.i > 0 ? "true" : "false";
+            return get_payload() > 0 ? "true" : "false";
 
         case ValueCode::OBJECT:
-            return this->inner.object->to_string();
+            return to_object()->to_string();
+
+        case ValueCode::STRING:
+            return to_atom().str();
 
         default:
             return "[exception]";
@@ -42,15 +45,30 @@ std::string Value::to_string() const
 
 double Value::to_number() const
 {
-    return
-        this->type == ValueCode::NUMBER ? this->inner.d :
-        this->type == ValueCode::INTEGER ? (double)this->inner.i :
-        this->type == ValueCode::BOOLEAN ? ( this->inner.i > 0 ? 1 : 0 ) :
-        0.0f;
+    switch(get_type())
+    {
+        case ValueCode::NUMBER:
+        {
+            double d;
+            memcpy(&d, &m_bits, sizeof(d));
+            return d;
+        }
+
+        case ValueCode::INTEGER:
+            return (double)(int32_t)get_payload();
+
+        case ValueCode::BOOLEAN:
+            return get_payload() > 0 ? 1 : 0;
+
+        default:
+            return 0.0f;
+    }
 }
 
 int32_t Value::to_integer() const
 {
+    if( get_type() == ValueCode::INTEGER )
+        return (int32_t)get_payload();
     return static_cast<int32_t>(to_number());
 }
 
@@ -59,4 +77,4 @@ bool Value::to_boolean() const
     return to_number() > 0;
 }
 
-NS_AVM_END
\ No newline at end of file
+NS_AVM_END
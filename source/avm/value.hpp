@@ -1,7 +1,9 @@
 #pragma once
 
 #include "avm/avm.hpp"
+#include "atom.hpp"
 
+#include <cstring>
 #include <string>
 
 NS_AVM_BEGIN
@@ -13,23 +15,28 @@ enum class ValueCode : uint8_t
     NUMBER,
     INTEGER,
     BOOLEAN,
-    OBJECT
+    OBJECT,
+    STRING      // interned by the atom table of virtual machine
 };
 
+// values are nan-boxed into 8 bytes. doubles are stored as they are, with
+// nans canonicalized, and the other types live in the negative quiet nan
+// space: bits 48-50 hold the type, and the low 48 bits hold the payload of
+// a pointer, a 32-bit integer or a boolean.
 struct Value
 {
-    union Innervalue
-    {
-        GCObject*   object;     // collectable objects
-        int64_t     i;          // integer numbers and booleans
-        double      d;          // float numbers;
-    };
+protected:
+    const static uint64_t TagMask   = 0xFFF8000000000000ULL;
+    const static uint64_t PayloadMask = 0x0000FFFFFFFFFFFFULL;
+    const static uint64_t CanonicalNaN = 0x7FF8000000000000ULL;
+
+    uint64_t    m_bits;
 
-    ValueCode   type;
-    Innervalue  inner;
+    static uint64_t box(ValueCode code, uint64_t payload);
+    uint64_t        get_payload() const;
 
-    Value() : type(ValueCode::UNDEFINED) {}
-    Value(const Value& rh) : inner(rh.inner), type(rh.type) {}
+public:
+    Value() : m_bits(box(ValueCode::UNDEFINED, 0)) {}
 
     Value& set_nil();
     Value& set_undefined();
@@ -37,7 +44,9 @@ struct Value
     Value& set_integer(int32_t);
     Value& set_boolean(bool);
     Value& set_object(GCObject*);
+    Value& set_atom(Atom);
 
+    ValueCode   get_type() const;
     std::string to_string() const;
 
     // converts value to floating-point
@@ -46,68 +55,102 @@ struct Value
     int32_t     to_integer() const;
     bool        to_boolean() const;
 
-    GCObject*   to_object()
+    // returns the empty atom if its not a string.
+    Atom        to_atom() const;
+
+    GCObject*   to_object() const
     {
-        if( this->type == ValueCode::OBJECT )
-            return this->inner.object;
+        if( get_type() == ValueCode::OBJECT )
+            return reinterpret_cast<GCObject*>(get_payload());
         return nullptr;
     }
 
-    template<typename T> T* to_object()
+    template<typename T> T* to_object() const
     {
-        if( this->type == ValueCode::OBJECT )
-            return dynamic_cast<T*>(this->inner.object);
-        return nullptr;
+        return dynamic_cast<T*>(to_object());
     }
 };
 
+static_assert( sizeof(Value) == 8, "values are expected to be nan-boxed." );
+
 /// INLINE METHODS
 
+inline uint64_t Value::box(ValueCode code, uint64_t payload)
+{
+    // the tag of 0 is the canonical negative nan, so its skipped
+    return TagMask | ((uint64_t)code + 1) << 48 | payload;
+}
+
+inline uint64_t Value::get_payload() const
+{
+    return m_bits & PayloadMask;
+}
+
+inline ValueCode Value::get_type() const
+{
+    if( (m_bits & TagMask) != TagMask || (m_bits & ~TagMask) >> 48 == 0 )
+        return ValueCode::NUMBER;
+    return (ValueCode)(((m_bits >> 48) & 0x7) - 1);
+}
+
 inline Value& Value::set_nil()
 {
-    this->type = ValueCode::NULLPTR;
+    m_bits = box(ValueCode::NULLPTR, 0);
     return *this;
 }
 
 inline Value& Value::set_undefined()
 {
-    this->type = ValueCode::UNDEFINED;
+    m_bits = box(ValueCode::UNDEFINED, 0);
     return *this;
 }
 
 inline Value& Value::set_number(double num)
 {
-    this->type = ValueCode::NUMBER;
-    this->inner.d = num;
+    if( num != num )
+        m_bits = CanonicalNaN;
+    else
+        memcpy(&m_bits, &num, sizeof(num));
     return *this;
 }
 
 inline Value& Value::set_integer(int32_t integer)
 {
-    this->type = ValueCode::INTEGER;
-    this->inner.i = integer;
+    m_bits = box(ValueCode::INTEGER, (uint32_t)integer);
     return *this;
 }
 
 inline Value& Value::set_boolean(bool boolean)
 {
-    this->type = ValueCode::INTEGER;
-    this->inner.i = boolean ? 1 : 0;
+    m_bits = box(ValueCode::BOOLEAN, boolean ? 1 : 0);
     return *this;
 }
 
+inline Value& Value::set_atom(Atom atom)
+{
+    auto address = (uint64_t)(uintptr_t)(atom.empty() ? nullptr : &atom.str());
+    assert( (address & ~PayloadMask) == 0 );
+
+    m_bits = box(ValueCode::STRING, address);
+    return *this;
+}
+
+inline Atom Value::to_atom() const
+{
+    if( get_type() == ValueCode::STRING )
+        return Atom(reinterpret_cast<const std::string*>(get_payload()));
+    return Atom();
+}
+
 inline Value& Value::set_object(GCObject* object)
 {
-    if( object != nullptr )
-    {
-        this->type = ValueCode::OBJECT;
-        this->inner.object = object;
-    }
-    else
-    {
-        this->type = ValueCode::NULLPTR;
-    }
-    
+    if( object == nullptr )
+        return set_nil();
+
+    auto address = (uint64_t)(uintptr_t)object;
+    assert( (address & ~PayloadMask) == 0 );
+
+    m_bits = box(ValueCode::OBJECT, address);
     return *this;
 }
 
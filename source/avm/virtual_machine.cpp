@@ -4,81 +4,385 @@
 #include "stream.hpp"
 #include "movie_clip.hpp"
 
+#include <algorithm>
+#include <chrono>
+
 NS_AVM_BEGIN
 
-const static int InitialGCThreshold = 4;
+const static uint32_t NurserySize = 256;
+const static uint32_t InitialMajorThreshold = 1024;
+const static uint32_t DefaultGCBudget = 500;
+// objects traced or swept between checking the time
+const static uint32_t GCWorkUnit = 64;
+// charges of loops between checking the timeout
+const static uint32_t TimeoutInterval = 64;
 
-VirtualMachine::VirtualMachine(int version)
-: m_gc_threshold(InitialGCThreshold), m_objects(0), m_version(version)
+static uint64_t now_microseconds()
 {
-    m_root = new GCObject();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+VirtualMachine::VirtualMachine(AtomTable& atoms, int version)
+: m_context(nullptr), m_young_objects(0), m_old_objects(0),
+m_major_threshold(InitialMajorThreshold), m_gc_budget(DefaultGCBudget),
+m_version(version), m_jit_mode(JitMode::DISABLED), m_atoms(atoms), m_phase(GCPhase::IDLE), m_minor(false),
+m_sweep(nullptr), m_instruction_budget(0), m_instructions_left(0), m_charges(0),
+m_max_recursion(256), m_timeout(0), m_aborted(false)
+{
+    m_young = new GCObject();
+    m_old = new GCObject();
 }
 
 VirtualMachine::~VirtualMachine()
 {
-    for(GCObject* current = m_root; current != nullptr;)
+    m_suspended.clear();
+
+    auto delete_list = [](GCObject* current)
+    {
+        while( current != nullptr )
+        {
+            auto tmp = current;
+            current = current->m_next;
+            delete tmp;
+        }
+    };
+
+    delete_list(m_young);
+    delete_list(m_old);
+    delete_list(m_context);
+
+    m_young = nullptr;
+    m_old = nullptr;
+    m_context = nullptr;
+}
+
+void VirtualMachine::execute(ContextObject* context, const ActionBlock& block)
+{
+    if( context == nullptr || m_aborted )
+        return;
+
+    // blocks are executed in order, so its queued behind suspended ones
+    auto env = MovieEnvironment(this, context, &block);
+    if( !m_suspended.empty() || !run(env) )
     {
-        auto tmp = current;
-        current = current->m_next;
-        delete tmp;
+        m_suspended.push_back(env);
+        return;
     }
-    m_root = nullptr;
 
-    for(GCObject* current = m_context; current != nullptr;)
+    // the operand stack is empty now, so contexts and suspended blocks are
+    // the only roots
+    if( m_phase == GCPhase::IDLE && m_young_objects > NurserySize )
+        minor_collect();
+
+    if( m_phase == GCPhase::IDLE && m_old_objects > m_major_threshold )
+        start_major();
+}
+
+void VirtualMachine::update()
+{
+    m_instructions_left = m_instruction_budget;
+
+    while( !m_suspended.empty() && !m_aborted )
     {
-        auto tmp = current;
-        current = current->m_next;
-        delete tmp;
+        // its taken out, the queue could be changed by freeing contexts
+        auto env = m_suspended.front();
+        m_suspended.pop_front();
+
+        if( !run(env) )
+        {
+            m_suspended.push_front(env);
+            break;
+        }
     }
-    m_context = nullptr;
+
+    if( m_phase == GCPhase::IDLE && m_young_objects > NurserySize )
+        minor_collect();
+
+    if( m_phase == GCPhase::IDLE && m_old_objects > m_major_threshold )
+        start_major();
 }
 
-void VirtualMachine::execute(ContextObject* context, const uint8_t* bytecode, int length)
+bool VirtualMachine::run(MovieEnvironment& env)
 {
-    if( context == nullptr )
-        return;
+    auto call = env.started == 0;
+    env.status = ExecutionStatus::RUNNING;
+    env.started = now_microseconds();
+
+    if( m_profiler == nullptr )
+        env.object->execute(env);
+    else
+    {
+        // blocks executed by this one are included
+        auto profiler = m_profiler.get();
+        auto start = ScriptProfiler::now();
+        env.object->execute(env);
+        profiler->add_block(*env.block, call, ScriptProfiler::now() - start);
+    }
+
+    if( env.status == ExecutionStatus::SUSPENDED )
+    {
+        env.elapsed += now_microseconds() - env.started;
+        return false;
+    }
+
+    if( env.status == ExecutionStatus::ABORTED )
+    {
+        // the same as the dialog of flash player, scripts are stopped for
+        // the rest of movie.
+        LERROR(LOG_AVM, "script runs longer than %d seconds, its aborted.\n", m_timeout);
+        m_aborted = true;
+        m_suspended.clear();
+    }
+
+    return true;
+}
+
+bool VirtualMachine::charge(MovieEnvironment& env, uint32_t instructions)
+{
+    if( m_timeout > 0 && ++m_charges % TimeoutInterval == 0 )
+    {
+        auto elapsed = now_microseconds() - env.started + env.elapsed;
+        if( elapsed > m_timeout * 1000000ull )
+        {
+            env.status = ExecutionStatus::ABORTED;
+            return false;
+        }
+    }
+
+    if( m_instruction_budget == 0 )
+        return true;
+
+    if( m_instructions_left > instructions )
+    {
+        m_instructions_left -= instructions;
+        return true;
+    }
 
-    auto stream = Stream(bytecode, length);
-    context->execute(*this, stream);
+    m_instructions_left = 0;
+    env.status = ExecutionStatus::SUSPENDED;
+    return false;
+}
 
-    if( m_objects > m_gc_threshold )
-        gabarge_collect();
+void VirtualMachine::set_profiling(bool enabled)
+{
+    if( !enabled )
+        m_profiler.reset();
+    else if( m_profiler == nullptr )
+        m_profiler.reset(new (std::nothrow) ScriptProfiler());
+}
+
+void VirtualMachine::shade_suspended()
+{
+    for( auto& env : m_suspended )
+    {
+        for( auto i=0; i<env.get_current_op(); i++ )
+            shade(env.get_operand(i).to_object());
+    }
+}
+
+void VirtualMachine::collect()
+{
+    if( m_phase == GCPhase::IDLE )
+        return;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(m_gc_budget);
+    do
+    {
+        if( m_phase == GCPhase::MARK )
+        {
+            if( mark_step(GCWorkUnit) )
+                finish_mark();
+        }
+        else
+            sweep_step(GCWorkUnit);
+    }
+    while( m_phase != GCPhase::IDLE && std::chrono::steady_clock::now() < deadline );
 }
 
 void VirtualMachine::gabarge_collect()
 {
-    int objects = m_objects;
+    if( m_phase == GCPhase::IDLE )
+        start_major();
+
+    while( m_phase == GCPhase::MARK )
+    {
+        if( mark_step(UINT32_MAX) )
+            finish_mark();
+    }
+
+    while( m_phase == GCPhase::SWEEP )
+        sweep_step(UINT32_MAX);
+}
+
+void VirtualMachine::write_barrier(GCObject* owner, GCObject* child)
+{
+    // keeps the invariant of marking that black objects refer to no white one
+    if( m_phase == GCPhase::MARK && owner->m_color == GCColor::BLACK )
+        shade(child);
+
+    // old objects referring to young ones are the extra roots of nursery
+    if( owner->m_old && !owner->m_remembered && !child->m_old )
+    {
+        owner->m_remembered = true;
+        m_remembered.push_back(owner);
+    }
+}
+
+void VirtualMachine::adopt(GCObject* object)
+{
+    object->m_vm = this;
+    object->m_next = m_young->m_next;
+    m_young->m_next = object;
+    m_young_objects ++;
+
+    // objects allocated while marking are reachable by definition
+    if( m_phase == GCPhase::MARK )
+        object->m_color = GCColor::BLACK;
+}
+
+void VirtualMachine::minor_collect()
+{
+    assert( m_phase == GCPhase::IDLE );
+
+    auto objects = m_young_objects;
+    uint32_t promoted = 0;
 
-    // mark
-    for(GCObject* current = m_context; current != nullptr; current = current->m_next)
-        current->mark(1);
+    m_minor = true;
+    for( GCObject* current = m_context; current != nullptr; current = current->m_next )
+        current->trace(*this);
+    shade_suspended();
+
+    for( auto object : m_remembered )
+    {
+        object->trace(*this);
+        object->m_remembered = false;
+    }
+    m_remembered.clear();
+
+    while( !m_gray.empty() )
+    {
+        auto object = m_gray.back();
+        m_gray.pop_back();
+        object->trace(*this);
+        object->m_color = GCColor::BLACK;
+    }
+    m_minor = false;
 
-    // sweep
-    for(GCObject* prev = m_root, *current = m_root->m_next; current != nullptr;)
+    // survivors are promoted, and the nursery is empty again
+    for( GCObject* current = m_young->m_next; current != nullptr; )
     {
-        if( current->m_marked == 0 )
+        auto next = current->m_next;
+        if( current->m_color == GCColor::WHITE )
+            delete current;
+        else
         {
-            prev->m_next = current->m_next;
+            current->m_color = GCColor::WHITE;
+            current->m_old = true;
+            current->m_next = m_old->m_next;
+            m_old->m_next = current;
+            promoted ++;
+        }
+        current = next;
+    }
+
+    m_young->m_next = nullptr;
+    m_young_objects = 0;
+    m_old_objects += promoted;
+
+    LDEBUG(LOG_AVM, "minor gc promoted %d of %d objects.\n", promoted, objects);
+}
+
+void VirtualMachine::start_major()
+{
+    assert( m_phase == GCPhase::IDLE );
+
+    m_phase = GCPhase::MARK;
+    for( GCObject* current = m_context; current != nullptr; current = current->m_next )
+        shade(current);
+    shade_suspended();
+}
+
+bool VirtualMachine::mark_step(uint32_t count)
+{
+    while( !m_gray.empty() && count-- > 0 )
+    {
+        auto object = m_gray.back();
+        m_gray.pop_back();
+        object->trace(*this);
+        object->m_color = GCColor::BLACK;
+    }
+
+    return m_gray.empty();
+}
+
+void VirtualMachine::finish_mark()
+{
+    // stacks of suspended blocks are changed without barriers, so they are
+    // scanned again before sweeping.
+    shade_suspended();
+    while( !mark_step(UINT32_MAX) ) {}
+
+    // the nursery is swept at once, black survivors are whitened by sweeping
+    // the old generation later.
+    for( GCObject* current = m_young->m_next; current != nullptr; )
+    {
+        auto next = current->m_next;
+        if( current->m_color == GCColor::WHITE )
             delete current;
-            current = prev->m_next;
-            m_objects--;
+        else
+        {
+            current->m_old = true;
+            current->m_next = m_old->m_next;
+            m_old->m_next = current;
+            m_old_objects ++;
+        }
+        current = next;
+    }
+
+    m_young->m_next = nullptr;
+    m_young_objects = 0;
+
+    // no young object is left to remember
+    for( auto object : m_remembered )
+        object->m_remembered = false;
+    m_remembered.clear();
+
+    for( GCObject* current = m_context; current != nullptr; current = current->m_next )
+        current->m_color = GCColor::WHITE;
+
+    m_phase = GCPhase::SWEEP;
+    m_sweep = m_old;
+}
+
+bool VirtualMachine::sweep_step(uint32_t count)
+{
+    while( m_sweep->m_next != nullptr && count-- > 0 )
+    {
+        auto current = m_sweep->m_next;
+        if( current->m_color == GCColor::WHITE )
+        {
+            m_sweep->m_next = current->m_next;
+            delete current;
+            m_old_objects --;
         }
         else
         {
             // unmark it for next gc
-            current->m_marked = 0;
-            prev = current;
-            current = current->m_next;
+            current->m_color = GCColor::WHITE;
+            m_sweep = current;
         }
     }
 
-    // 
-    m_gc_threshold = m_objects * 2;
+    if( m_sweep->m_next != nullptr )
+        return false;
+
+    m_phase = GCPhase::IDLE;
+    m_sweep = nullptr;
+    m_major_threshold = std::max(InitialMajorThreshold, m_old_objects * 2);
 
-#ifdef DEBUG_AVM
-    printf("[AVM] gabarge collected %d objects, %d remaining.\n",
-        objects - m_objects, m_objects);
-#endif
+    LDEBUG(LOG_AVM, "major gc finished, %d objects remaining.\n", m_old_objects);
+    return true;
 }
 
 ContextObject* VirtualMachine::new_context(MovieNode* node)
@@ -86,10 +390,19 @@ ContextObject* VirtualMachine::new_context(MovieNode* node)
     if( node == nullptr )
         return nullptr;
 
-    auto context = new ContextObject();
-    context->attach(node);
+    // contexts are roots, they are scanned by every collection instead of
+    // being remembered.
+    auto context = new ContextObject(&m_root_layout);
+    context->m_vm = this;
+    context->m_old = true;
+    context->m_remembered = true;
+
+    context->attach(node, m_atoms);
     node->set_context(context);
 
+    if( m_phase == GCPhase::MARK )
+        shade(context);
+
     if( m_context == nullptr )
         m_context = context;
     else
@@ -108,6 +421,12 @@ void VirtualMachine::free_context(ContextObject* context)
 
     context->detach();
 
+    m_suspended.erase(std::remove_if(m_suspended.begin(), m_suspended.end(),
+        [=](const MovieEnvironment& env) { return env.object == context; }), m_suspended.end());
+
+    if( m_phase == GCPhase::MARK )
+        m_gray.erase(std::remove(m_gray.begin(), m_gray.end(), context), m_gray.end());
+
     for(GCObject* current = m_context, *prev = m_context;
         current != nullptr;
         prev = current, current = current->m_next)
@@ -129,4 +448,4 @@ void VirtualMachine::free_context(ContextObject* context)
     }
 }
 
-NS_AVM_END
\ No newline at end of file
+NS_AVM_END
@@ -2,45 +2,206 @@
 
 #include "avm/avm.hpp"
 #include "avm/context_object.hpp"
+#include "avm/script_profiler.hpp"
+
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
 
 NS_AVM_BEGIN
 
+enum class GCPhase : uint8_t
+{
+    IDLE = 0,
+    MARK,       // tracing gray objects incrementally
+    SWEEP       // freeing white objects of old generation incrementally
+};
+
+// objects are allocated in the nursery, which is collected as a whole once
+// its full and survivors are promoted into the old generation. the old
+// generation is collected by an incremental mark-sweep, which is advanced by
+// collect() within a time budget every frame. contexts are the roots.
+//
+// loops of scripts are charged against a instruction budget of each frame,
+// a block out of budget is suspended and resumed in the next frame, and the
+// blocks executed after it are queued behind to keep their order.
 class VirtualMachine
 {
+    friend class ContextObject;
+
 protected:
-    GCObject*       m_root;
+    GCObject*       m_young;        // the sentinel of nursery
+    GCObject*       m_old;          // the sentinel of old generation
     ContextObject*  m_context;
-    uint32_t        m_gc_threshold;
-    uint32_t        m_objects;
+    uint32_t        m_young_objects;
+    uint32_t        m_old_objects;
+    uint32_t        m_major_threshold;
+    uint32_t        m_gc_budget;    // microseconds of collection per frame
     int32_t         m_version;
+    JitMode         m_jit_mode;
+    AtomTable&      m_atoms;
+    ObjectLayout    m_root_layout;  // the empty layout which objects start from
+
+    GCPhase                 m_phase;
+    bool                    m_minor;        // tracing the nursery only
+    std::vector<GCObject*>  m_gray;
+    std::vector<GCObject*>  m_remembered;   // old objects referring to young ones
+    GCObject*               m_sweep;        // the object before the next to sweep
+
+    std::deque<MovieEnvironment>    m_suspended;    // resumed in order by update()
+    uint32_t                m_instruction_budget;   // of each frame, 0 is unlimited
+    uint32_t                m_instructions_left;
+    uint32_t                m_charges;
+    uint16_t                m_max_recursion;
+    uint16_t                m_timeout;              // seconds, 0 is unlimited
+    bool                    m_aborted;
+
+    std::unique_ptr<ScriptProfiler> m_profiler; // nullptr unless profiling
 
 public:
-    VirtualMachine(int version = 10);
+    // strings of scripts are interned by the atoms, which are shared with
+    // the names of display nodes.
+    VirtualMachine(AtomTable& atoms, int version = 10);
     ~VirtualMachine();
 
-    void execute(ContextObject*, const uint8_t* bytes, int length);
+    void execute(ContextObject*, const ActionBlock& block);
+    // renews the instruction budget, and resumes the suspended blocks. its
+    // called once a frame before the timeline advances.
+    void update();
+    // returns false if the environment is out of budget or timed out.
+    bool charge(MovieEnvironment& env, uint32_t instructions);
+
+    // advances the incremental collection until its budget runs out, its
+    // called once a frame while no action is being executed.
+    void collect();
+    // finishes the current cycle, and runs a full one.
     void gabarge_collect();
 
-    template<typename T> T* new_object()
+    template<typename T, typename ... Args> T* new_object(Args&& ... args)
     {
-        auto nv = new T();
-        nv->m_next = m_root->m_next;
-        m_root->m_next = nv;
-        m_objects ++;
+        auto nv = new T(std::forward<Args>(args)...);
+        adopt(nv);
         return nv;
     }
- 
+
     ContextObject*  new_context(MovieNode*);
     void            free_context(ContextObject*);
 
-    int32_t get_version() const;
+    // makes the white object gray, objects of old generation are ignored
+    // by minor collections.
+    void            shade(GCObject*);
+    void            write_barrier(GCObject* owner, GCObject* child);
+
+    void            set_gc_budget(uint32_t microseconds);
+    void            set_jit_mode(JitMode mode);
+    void            set_instruction_budget(uint32_t per_frame);
+    // from ScriptLimits tag, scripts are disabled once one times out
+    void            set_script_limits(uint16_t max_recursion, uint16_t timeout);
+    uint32_t        get_suspended_count() const;
+    bool            is_aborted() const;
+    // the costs recorded are discarded once its disabled
+    void            set_profiling(bool enabled);
+    ScriptProfiler* get_profiler();
+    JitMode         get_jit_mode() const;
+    GCPhase         get_gc_phase() const;
+    uint32_t        get_object_count() const;
+    int32_t         get_version() const;
+    AtomTable&      get_atoms();
+    ObjectLayout*   get_root_layout();
+
+protected:
+    // returns false if its suspended
+    bool run(MovieEnvironment& env);
+    void shade_suspended();
+
+    void adopt(GCObject*);
+    void minor_collect();
+    void start_major();
+    bool mark_step(uint32_t count);
+    void finish_mark();
+    bool sweep_step(uint32_t count);
 };
 
 // INLINE METHODS
 
+inline void VirtualMachine::shade(GCObject* object)
+{
+    if( object == nullptr || object->m_color != GCColor::WHITE )
+        return;
+
+    if( m_minor && object->m_old )
+        return;
+
+    object->m_color = GCColor::GRAY;
+    m_gray.push_back(object);
+}
+
+inline void VirtualMachine::set_gc_budget(uint32_t microseconds)
+{
+    m_gc_budget = microseconds;
+}
+
+inline void VirtualMachine::set_jit_mode(JitMode mode)
+{
+    m_jit_mode = mode;
+}
+
+inline JitMode VirtualMachine::get_jit_mode() const
+{
+    return m_jit_mode;
+}
+
+inline void VirtualMachine::set_instruction_budget(uint32_t per_frame)
+{
+    m_instruction_budget = per_frame;
+    m_instructions_left = per_frame;
+}
+
+inline void VirtualMachine::set_script_limits(uint16_t max_recursion, uint16_t timeout)
+{
+    m_max_recursion = max_recursion;
+    m_timeout = timeout;
+}
+
+inline uint32_t VirtualMachine::get_suspended_count() const
+{
+    return m_suspended.size();
+}
+
+inline bool VirtualMachine::is_aborted() const
+{
+    return m_aborted;
+}
+
+inline ScriptProfiler* VirtualMachine::get_profiler()
+{
+    return m_profiler.get();
+}
+
+inline GCPhase VirtualMachine::get_gc_phase() const
+{
+    return m_phase;
+}
+
+inline uint32_t VirtualMachine::get_object_count() const
+{
+    return m_young_objects + m_old_objects;
+}
+
 inline int32_t VirtualMachine::get_version() const
 {
     return m_version;
 }
 
-NS_AVM_END
\ No newline at end of file
+inline AtomTable& VirtualMachine::get_atoms()
+{
+    return m_atoms;
+}
+
+inline ObjectLayout* VirtualMachine::get_root_layout()
+{
+    return &m_root_layout;
+}
+
+NS_AVM_END
@@ -0,0 +1,10 @@
+#include "character.hpp"
+#include "player.hpp"
+
+namespace openswf
+{
+    void INode::set_name(const std::string& name)
+    {
+        set_name(m_player->get_atoms().intern(name));
+    }
+}
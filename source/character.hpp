@@ -2,6 +2,7 @@
 
 #include "types.hpp"
 #include "shader.hpp"
+#include "atom.hpp"
 
 #include <vector>
 #include <string>
@@ -34,27 +35,31 @@ namespace openswf
         Matrix          m_matrix;
         ColorTransform  m_cxform;
         uint16_t        m_ratio;
-        std::string     m_name;
+        Atom            m_name;
         uint16_t        m_clip_depth;
 
     public:
         INode(Player* env, ICharacter* ch)
-        : m_player(env), m_character(ch), m_ratio(0) {}
+        : m_player(env), m_character(ch), m_ratio(0), m_clip_depth(0) {}
 
         virtual ~INode() {}
         virtual void update(float dt) = 0;
         virtual void render(const Matrix& matrix, const ColorTransform& cxform) = 0;
         virtual uint16_t get_character_id() const;
+        // restores the attributes of a new instance, before its recycled.
+        virtual void reset();
 
         void set_transform(const Matrix& matrix);
         void set_cxform(const ColorTransform& cxform);
         void set_ratio(uint16_t ratio);
         void set_name(const std::string& name);
+        virtual void set_name(Atom name);
         void set_clip_depth(uint16_t clip_depth);
 
         Point2f get_position() const;
         Point2f get_scale() const;
         const std::string&  get_name() const;
+        Atom                get_name_atom() const;
     };
 
     /// INLINE METHODS
@@ -63,6 +68,15 @@ namespace openswf
         return m_character->get_character_id();
     }
 
+    inline void INode::reset()
+    {
+        m_matrix.set_identity();
+        m_cxform.set_identity();
+        m_ratio = 0;
+        m_name = Atom();
+        m_clip_depth = 0;
+    }
+
     inline void INode::set_transform(const Matrix& matrix)
     {
         m_matrix = matrix;
@@ -78,7 +92,7 @@ namespace openswf
         m_ratio = ratio;
     }
 
-    inline void INode::set_name(const std::string& name)
+    inline void INode::set_name(Atom name)
     {
         m_name = name;
     }
@@ -99,6 +113,11 @@ namespace openswf
     }
 
     inline const std::string& INode::get_name() const
+    {
+        return m_name.str();
+    }
+
+    inline Atom INode::get_name_atom() const
     {
         return m_name;
     }
@@ -2,8 +2,6 @@
 
 #include <cassert>
 
-#define LERROR(message) printf("[%s] %s", "ERRO", message);
-#define LWARNING(message) printf("[%s] %s", "WARN", message);
-#define LINFO(message) printf("[%s] %s", "INFO", message);
+#include "log.hpp"
 
 #define DEBUG_ACTION_SCRIPT
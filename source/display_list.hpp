@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace openswf
+{
+    class INode;
+
+    // the children of a movie node sorted by depth, kept in a flat vector so
+    // traversals are linear scans of memory. timelines almost always place
+    // characters at increasing depths, so appending at the top depth is O(1),
+    // and the others are found by binary search.
+    class DisplayList
+    {
+    public:
+        typedef std::pair<uint16_t, INode*>     Entry;
+        typedef std::vector<Entry>::iterator    iterator;
+
+    protected:
+        std::vector<Entry>  m_entries;
+
+    public:
+        iterator    begin();
+        iterator    end();
+        size_t      size() const;
+        bool        empty() const;
+        void        clear();
+
+        // returns end() if there is no node at depth
+        iterator    find(uint16_t depth);
+        iterator    erase(iterator);
+        // the node at depth, a null one is inserted if not exists
+        INode*&     operator[](uint16_t depth);
+
+    protected:
+        iterator    lower_bound(uint16_t depth);
+    };
+
+    /// INLINE METHODS
+    inline DisplayList::iterator DisplayList::begin()
+    {
+        return m_entries.begin();
+    }
+
+    inline DisplayList::iterator DisplayList::end()
+    {
+        return m_entries.end();
+    }
+
+    inline size_t DisplayList::size() const
+    {
+        return m_entries.size();
+    }
+
+    inline bool DisplayList::empty() const
+    {
+        return m_entries.empty();
+    }
+
+    inline void DisplayList::clear()
+    {
+        m_entries.clear();
+    }
+
+    inline DisplayList::iterator DisplayList::lower_bound(uint16_t depth)
+    {
+        if( m_entries.empty() || m_entries.back().first < depth )
+            return m_entries.end();
+
+        return std::lower_bound(m_entries.begin(), m_entries.end(), depth,
+            [](const Entry& entry, uint16_t depth) { return entry.first < depth; });
+    }
+
+    inline DisplayList::iterator DisplayList::find(uint16_t depth)
+    {
+        auto iter = lower_bound(depth);
+        if( iter != m_entries.end() && iter->first == depth )
+            return iter;
+        return m_entries.end();
+    }
+
+    inline DisplayList::iterator DisplayList::erase(iterator iter)
+    {
+        return m_entries.erase(iter);
+    }
+
+    inline INode*& DisplayList::operator[](uint16_t depth)
+    {
+        auto iter = lower_bound(depth);
+        if( iter == m_entries.end() )
+        {
+            m_entries.push_back(Entry(depth, nullptr));
+            return m_entries.back().second;
+        }
+
+        if( iter->first != depth )
+            iter = m_entries.insert(iter, Entry(depth, nullptr));
+        return iter->second;
+    }
+}
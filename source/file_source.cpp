@@ -0,0 +1,71 @@
+#include "file_source.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace openswf
+{
+    FileSourcePtr FileSource::create(const char* path)
+    {
+        auto source = new (std::nothrow) FileSource();
+        if( source && source->initialize(path) )
+            return FileSourcePtr(source);
+
+        if( source ) delete source;
+        return nullptr;
+    }
+
+    bool FileSource::initialize(const char* path)
+    {
+        auto fd = open(path, O_RDONLY);
+        if( fd < 0 )
+        {
+            LWARNING(LOG_LOADER, "failed to open %s.\n", path);
+            return false;
+        }
+
+        struct stat st;
+        if( fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > UINT32_MAX )
+        {
+            LWARNING(LOG_LOADER, "%s is not a valid swf file.\n", path);
+            close(fd);
+            return false;
+        }
+
+        auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // the mapping keeps its own reference to the file
+        close(fd);
+
+        if( data == MAP_FAILED )
+        {
+            LWARNING(LOG_LOADER, "failed to map %s.\n", path);
+            return false;
+        }
+
+        m_data = (const uint8_t*)data;
+        m_size = (uint32_t)st.st_size;
+        return true;
+    }
+
+    FileSource::~FileSource()
+    {
+        if( m_data != nullptr )
+        {
+            munmap((void*)m_data, m_size);
+            m_data = nullptr;
+        }
+    }
+
+    void FileSource::advise(FileAccess access)
+    {
+        int advice = MADV_NORMAL;
+        if( access == FileAccess::SEQUENTIAL )
+            advice = MADV_SEQUENTIAL;
+        else if( access == FileAccess::RANDOM )
+            advice = MADV_RANDOM;
+
+        madvise((void*)m_data, m_size, advice);
+    }
+}
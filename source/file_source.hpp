@@ -0,0 +1,58 @@
+#pragma once
+
+#include "stream.hpp"
+
+#include <memory>
+
+namespace openswf
+{
+    class FileSource;
+    typedef std::unique_ptr<FileSource> FileSourcePtr;
+
+    enum class FileAccess : uint8_t
+    {
+        NORMAL = 0,
+        SEQUENTIAL, // tags are scanned from the beginning to the end
+        RANDOM,     // characters are parsed on demand
+    };
+
+    // a read-only memory mapping of a swf file, pages are loaded by os on
+    // demand and shared with other processes mapping the same file.
+    // streams handed out are valid during the life of file source.
+    class FileSource
+    {
+    protected:
+        const uint8_t*  m_data;
+        uint32_t        m_size;
+
+    public:
+        static FileSourcePtr create(const char* path);
+        ~FileSource();
+
+        // hints the kernel how the mapping would be accessed from now on
+        void            advise(FileAccess access);
+
+        Stream          get_stream() const;
+        const uint8_t*  get_data() const;
+        uint32_t        get_size() const;
+
+    protected:
+        FileSource() : m_data(nullptr), m_size(0) {}
+        bool initialize(const char* path);
+    };
+
+    inline Stream FileSource::get_stream() const
+    {
+        return Stream(m_data, m_size);
+    }
+
+    inline const uint8_t* FileSource::get_data() const
+    {
+        return m_data;
+    }
+
+    inline uint32_t FileSource::get_size() const
+    {
+        return m_size;
+    }
+}
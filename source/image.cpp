@@ -1,4 +1,5 @@
 #include "image.hpp"
+#include "player.hpp"
 
 namespace openswf
 {
@@ -25,6 +26,10 @@ namespace openswf
     {
         if( m_rid == 0 )
         {
+            auto profiler = m_player ? m_player->get_load_profiler() : nullptr;
+            ProfileScope scope(profiler ? profiler->find_character(m_character_id) : nullptr,
+                LOAD_PHASE_TEXTURE_UPLOAD);
+
             m_rid = Render::get_instance().create_texture(
                 m_bitmap->get_ptr(), m_bitmap->get_width(), m_bitmap->get_height(),
                 m_bitmap->get_format(), 1);
@@ -35,7 +40,7 @@ namespace openswf
 
     INode* Image::create_instance()
     {
-        return new ImageNode(this->m_player, this);
+        return m_player->get_node_pool().create<ImageNode>(m_player, this);
     }
 
     uint16_t Image::get_character_id() const
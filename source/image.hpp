@@ -2,6 +2,7 @@
 
 #include "character.hpp"
 #include "shader.hpp"
+#include "profiler.hpp"
 
 namespace openswf
 {
@@ -41,6 +42,7 @@ namespace openswf
                 return nullptr;
             }
 
+            ProfileScope::count_allocation(width*height*T::size);
             return Ptr(bitmap);
         }
 
@@ -193,6 +195,7 @@ namespace openswf
         virtual uint16_t get_character_id() const;
 
         Rid             get_texture_rid();
+        const IBitmap&  get_bitmap() const;
         TextureFormat   get_texture_format() const;
         float           get_width() const;
         float           get_height() const;
@@ -212,6 +215,11 @@ namespace openswf
     };
 
     // INLINE METHODS
+    inline const IBitmap& Image::get_bitmap() const
+    {
+        return *m_bitmap;
+    }
+
     inline TextureFormat Image::get_texture_format() const
     {
         return m_bitmap->get_format();
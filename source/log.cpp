@@ -0,0 +1,132 @@
+#include "log.hpp"
+
+#include <cstdio>
+
+namespace openswf
+{
+    static_assert( LOG_CATEGORY_COUNT == 5, "default levels of categories." );
+    std::atomic<uint8_t> Logger::s_levels[LOG_CATEGORY_COUNT] = {
+        { LOG_LEVEL_INFO }, { LOG_LEVEL_INFO }, { LOG_LEVEL_INFO },
+        { LOG_LEVEL_INFO }, { LOG_LEVEL_INFO } };
+
+    static const char* s_level_tags[] = { "TRAC", "DEBG", "INFO", "WARN", "ERRO", "OFF" };
+
+    static void write_stdout(LogLevel level, LogCategory, const char* message)
+    {
+        printf("[%s] %s", s_level_tags[level], message);
+    }
+
+    Logger& Logger::get_instance()
+    {
+        static Logger s_instance;
+        return s_instance;
+    }
+
+    Logger::Logger()
+    : m_head(0), m_tail(0), m_dropped(0), m_sink(write_stdout)
+    {
+        m_flushing.clear();
+        for( uint32_t i=0; i<Capacity; i++ )
+            m_records[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    Logger::~Logger()
+    {
+        flush();
+    }
+
+    void Logger::set_level(LogCategory category, LogLevel level)
+    {
+        s_levels[category].store(level, std::memory_order_relaxed);
+    }
+
+    void Logger::set_level(LogLevel level)
+    {
+        for( auto i=0; i<LOG_CATEGORY_COUNT; i++ )
+            set_level((LogCategory)i, level);
+    }
+
+    void Logger::set_sink(Sink sink)
+    {
+        flush();
+        m_sink = sink ? sink : Sink(write_stdout);
+    }
+
+    // a bounded queue of multiple producers, the sequence of record tells
+    // whether its free for the position of writing, or ready for reading.
+    bool Logger::push(LogLevel level, LogCategory category, const char* format, va_list args)
+    {
+        auto position = m_head.load(std::memory_order_relaxed);
+        Record* record = nullptr;
+        for( ;; )
+        {
+            record = &m_records[position % Capacity];
+            auto sequence = record->sequence.load(std::memory_order_acquire);
+            auto diff = (int32_t)(sequence - position);
+            if( diff == 0 )
+            {
+                if( m_head.compare_exchange_weak(position, position+1, std::memory_order_relaxed) )
+                    break;
+            }
+            else if( diff < 0 )
+                return false; // full
+            else
+                position = m_head.load(std::memory_order_relaxed);
+        }
+
+        record->level = level;
+        record->category = category;
+        vsnprintf(record->message, MessageSize, format, args);
+        record->sequence.store(position+1, std::memory_order_release);
+        return true;
+    }
+
+    void Logger::write(LogLevel level, LogCategory category, const char* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        auto pushed = push(level, category, format, args);
+        va_end(args);
+
+        if( !pushed )
+        {
+            // makes room and tries once more
+            flush();
+
+            va_start(args, format);
+            pushed = push(level, category, format, args);
+            va_end(args);
+
+            if( !pushed )
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        auto pending = m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_acquire);
+        if( level >= LOG_LEVEL_WARNING || pending >= Capacity / 2 )
+            flush();
+    }
+
+    void Logger::flush()
+    {
+        // only one thread writes to sink at the same time
+        if( m_flushing.test_and_set(std::memory_order_acquire) )
+            return;
+
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        for( ;; )
+        {
+            auto& record = m_records[tail % Capacity];
+            if( record.sequence.load(std::memory_order_acquire) != tail+1 )
+                break;
+
+            m_sink((LogLevel)record.level, (LogCategory)record.category, record.message);
+            record.sequence.store(tail + Capacity, std::memory_order_release);
+            m_tail.store(++tail, std::memory_order_release);
+        }
+
+        m_flushing.clear(std::memory_order_release);
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <functional>
+
+// the lowest level compiled, the logging below is removed by preprocessor:
+// 0 trace, 1 debug, 2 info, 3 warning, 4 error, 5 off.
+#ifndef OPENSWF_LOG_LEVEL
+    #ifdef DEBUG
+        #define OPENSWF_LOG_LEVEL 0
+    #else
+        #define OPENSWF_LOG_LEVEL 2
+    #endif
+#endif
+
+namespace openswf
+{
+    enum LogLevel
+    {
+        LOG_LEVEL_TRACE     = 0,
+        LOG_LEVEL_DEBUG     = 1,
+        LOG_LEVEL_INFO      = 2,
+        LOG_LEVEL_WARNING   = 3,
+        LOG_LEVEL_ERROR     = 4,
+        LOG_LEVEL_OFF       = 5
+    };
+
+    enum LogCategory
+    {
+        LOG_GENERIC         = 0,
+        LOG_LOADER,         // files, decompression and tag loop
+        LOG_PARSER,         // definitions of characters
+        LOG_AVM,            // action script
+        LOG_RENDER,
+
+        LOG_CATEGORY_COUNT
+    };
+
+    // records are formatted by the calling thread into a fixed ring buffer
+    // without any lock, and written to the sink by flush(), which is done by
+    // Player::update, when the buffer is filling up, or right after a warning.
+    // records are dropped if the buffer is full and another thread is flushing.
+    class Logger
+    {
+    public:
+        typedef std::function<void(LogLevel, LogCategory, const char*)> Sink;
+
+        const static uint32_t Capacity      = 256;
+        const static uint32_t MessageSize   = 240;
+
+    protected:
+        struct Record
+        {
+            std::atomic<uint32_t>   sequence;
+            uint8_t                 level;
+            uint8_t                 category;
+            char                    message[MessageSize];
+        };
+
+        static std::atomic<uint8_t> s_levels[LOG_CATEGORY_COUNT];
+
+        Record                  m_records[Capacity];
+        std::atomic<uint32_t>   m_head;
+        std::atomic<uint32_t>   m_tail;     // written by the flushing thread only
+        std::atomic_flag        m_flushing;
+        std::atomic<uint32_t>   m_dropped;
+        Sink                    m_sink;
+
+    public:
+        static Logger& get_instance();
+        ~Logger();
+
+        static bool is_enabled(LogCategory category, LogLevel level);
+        // the default runtime level of all categories is info.
+        static void set_level(LogCategory category, LogLevel level);
+        static void set_level(LogLevel level);
+
+        // the sink is called by one thread at a time, nullptr restores stdout.
+        // its not safe to change the sink while others are logging.
+        void        set_sink(Sink sink);
+        void        write(LogLevel level, LogCategory category, const char* format, ...)
+            __attribute__((format(printf, 4, 5)));
+        void        flush();
+        uint32_t    get_dropped() const;
+
+    protected:
+        Logger();
+        bool push(LogLevel level, LogCategory category, const char* format, va_list args);
+    };
+
+    /// INLINE METHODS
+    inline bool Logger::is_enabled(LogCategory category, LogLevel level)
+    {
+        return level >= s_levels[category].load(std::memory_order_relaxed);
+    }
+
+    inline uint32_t Logger::get_dropped() const
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+}
+
+#define OPENSWF_LOG(level, category, ...) \
+    do { \
+        if( openswf::Logger::is_enabled(category, level) ) \
+            openswf::Logger::get_instance().write(level, category, __VA_ARGS__); \
+    } while(0)
+
+// the arguments of logging removed are still referenced, but never evaluated
+#define OPENSWF_LOG_DISABLED(category, ...) \
+    do { \
+        if( false ) \
+            openswf::Logger::get_instance().write(openswf::LOG_LEVEL_OFF, category, __VA_ARGS__); \
+    } while(0)
+
+#if OPENSWF_LOG_LEVEL <= 0
+    #define LTRACE(category, ...) OPENSWF_LOG(openswf::LOG_LEVEL_TRACE, category, __VA_ARGS__)
+#else
+    #define LTRACE(category, ...) OPENSWF_LOG_DISABLED(category, __VA_ARGS__)
+#endif
+
+#if OPENSWF_LOG_LEVEL <= 1
+    #define LDEBUG(category, ...) OPENSWF_LOG(openswf::LOG_LEVEL_DEBUG, category, __VA_ARGS__)
+#else
+    #define LDEBUG(category, ...) OPENSWF_LOG_DISABLED(category, __VA_ARGS__)
+#endif
+
+#if OPENSWF_LOG_LEVEL <= 2
+    #define LINFO(category, ...) OPENSWF_LOG(openswf::LOG_LEVEL_INFO, category, __VA_ARGS__)
+#else
+    #define LINFO(category, ...) OPENSWF_LOG_DISABLED(category, __VA_ARGS__)
+#endif
+
+#if OPENSWF_LOG_LEVEL <= 3
+    #define LWARNING(category, ...) OPENSWF_LOG(openswf::LOG_LEVEL_WARNING, category, __VA_ARGS__)
+#else
+    #define LWARNING(category, ...) OPENSWF_LOG_DISABLED(category, __VA_ARGS__)
+#endif
+
+#if OPENSWF_LOG_LEVEL <= 4
+    #define LERROR(category, ...) OPENSWF_LOG(openswf::LOG_LEVEL_ERROR, category, __VA_ARGS__)
+#else
+    #define LERROR(category, ...) OPENSWF_LOG_DISABLED(category, __VA_ARGS__)
+#endif
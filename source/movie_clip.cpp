@@ -7,158 +7,54 @@
 namespace openswf
 {
     /// SPRITE CHARACTER
-    enum PlaceObject2Mask
+    void FrameCommand::execute(MovieClip& movie, MovieNode& clip) const
     {
-        PLACE_2_HAS_MOVE            = 0x01,
-        PLACE_2_HAS_CHARACTER       = 0x02,
-        PLACE_2_HAS_MATRIX          = 0x04,
-        PLACE_2_HAS_CXFORM          = 0x08,
-        PLACE_2_HAS_RATIO           = 0x10,
-        PLACE_2_HAS_NAME            = 0x20,
-        PLACE_2_HAS_CLIP_DEPTH      = 0x40,
-        PLACE_2_HAS_CLIP_ACTIONS    = 0x80
-    };
-
-    enum PlaceObject3Mask
-    {
-        PLACE_3_HAS_FILTERS         = 0x01,
-        PLACE_3_HAS_BLEND_MODE      = 0x02,
-        PLACE_3_HAS_CACHE_AS_BITMAP = 0x04,
-        PLACE_3_HAS_CLASS_NAME      = 0x08,
-        PLACE_3_HAS_IMAGE           = 0x10,
-        PLACE_3_HAS_VISIBLE         = 0x20,
-        PLACE_3_OPAQUE_BACKGROUND   = 0x40,
-        PLACE_3_RESERVED_1          = 0x80,
-    };
-
-    CommandPtr FrameCommand::create(TagHeader header, BytesPtr bytes)
-    {
-        auto command = new (std::nothrow) FrameCommand();
-        if( command )
+        if( type == FrameCommandType::REMOVE )
         {
-            assert(
-                header.code == TagCode::PLACE_OBJECT ||
-                header.code == TagCode::PLACE_OBJECT2 ||
-                header.code == TagCode::PLACE_OBJECT3 ||
-                header.code == TagCode::REMOVE_OBJECT ||
-                header.code == TagCode::REMOVE_OBJECT2);
-
-            command->m_header = header;
-            command->m_bytes = std::move(bytes);
-            return CommandPtr(command);
-        }
-
-        return CommandPtr();
-    }
-
-    void FrameCommand::execute(MovieClip& movie, MovieNode& clip)
-    {
-        auto stream = Stream(m_bytes.get(), m_header.size);
-        if( m_header.code == TagCode::PLACE_OBJECT )
-        {
-            auto character_id   = stream.read_uint16();
-            auto depth          = stream.read_uint16();
-            auto node = clip.set(depth, character_id);
-
-            if( node == nullptr ) return;
-
-            node->set_transform(stream.read_matrix().to_pixel(false));
-
-            if( stream.get_position() < m_header.size )
-                node->set_cxform(stream.read_cxform_rgb());
+            clip.erase(depth);
+            return;
         }
-        else if( m_header.code == TagCode::PLACE_OBJECT2 )
-        {
-            auto mask = stream.read_uint8();
-            auto depth = stream.read_uint16();
-
-            INode* node = nullptr;
-            if( mask & PLACE_2_HAS_CHARACTER )
-                node = clip.set(depth, stream.read_uint16());
-            else
-                node = clip.get(depth);
-
-            if( node == nullptr ) return;
-
-            if( mask & PLACE_2_HAS_MATRIX )
-                node->set_transform(stream.read_matrix().to_pixel(false));
-
-            if( mask & PLACE_2_HAS_CXFORM )
-                node->set_cxform(stream.read_cxform_rgba());
 
-            if( mask & PLACE_2_HAS_RATIO )
-                node->set_ratio(stream.read_uint16());
+        INode* node = nullptr;
+        if( mask & PLACE_2_HAS_CHARACTER )
+            node = clip.set(depth, character_id);
+        else
+            node = clip.get(depth);
 
-            if( mask & PLACE_2_HAS_NAME )
-                node->set_name(stream.read_string());
+        if( node == nullptr ) return;
 
-            if( mask & PLACE_2_HAS_CLIP_DEPTH )
-                node->set_clip_depth(stream.read_uint16());
+        if( mask & PLACE_2_HAS_MATRIX )
+            node->set_transform(matrix);
 
-            // skip clip actions
-        }
-        else if( m_header.code == TagCode::PLACE_OBJECT3 )
-        {
-            auto mask2 = stream.read_uint8();
-            /*auto mask3 = */stream.read_uint8();
-            auto depth = stream.read_uint16();
-
-//            std::string name;
-//            if( (mask3 & PLACE_3_HAS_CLASS_NAME) ||
-//                ((mask3 & PLACE_3_HAS_IMAGE) && (mask2 & PLACE_2_HAS_CHARACTER)) )
-//            {
-//                name = stream.read_string();
-//            }
-
-            INode* node = nullptr;
-            if( mask2 & PLACE_2_HAS_CHARACTER )
-            {
-                auto cid = stream.read_uint16();
-                node = clip.set(depth, cid);
-            }
-            else
-                node = clip.get(depth);
-
-            if( node == nullptr ) return;
+        if( mask & PLACE_2_HAS_CXFORM )
+            node->set_cxform(cxform);
 
-            if( mask2 & PLACE_2_HAS_MATRIX )
-                node->set_transform(stream.read_matrix().to_pixel(false));
+        if( mask & PLACE_2_HAS_RATIO )
+            node->set_ratio(ratio);
 
-            if( mask2 & PLACE_2_HAS_CXFORM )
-                node->set_cxform(stream.read_cxform_rgba());
+        if( mask & PLACE_2_HAS_NAME )
+            node->set_name(movie.get_name(name));
 
-            if( mask2 & PLACE_2_HAS_RATIO )
-                node->set_ratio(stream.read_uint16());
+        if( mask & PLACE_2_HAS_CLIP_DEPTH )
+            node->set_clip_depth(clip_depth);
+    }
 
-            if( mask2 & PLACE_2_HAS_NAME )
-                node->set_name(stream.read_string());
+    ActionPtr FrameAction::create(TagHeader header, const uint8_t* bytes, AtomTable& atoms,
+        int32_t version, uint16_t character_id, uint16_t frame)
+    {
+        assert(header.code == TagCode::DO_ACTION);
 
-            if( mask2 & PLACE_2_HAS_CLIP_DEPTH )
-                node->set_clip_depth(stream.read_uint16());
+        auto block = avm::ActionBlock::compile(bytes, header.size, atoms, version);
+        if( block == nullptr )
+            return ActionPtr();
 
-            // skip surface filters, bitmap cache, visible,
-            // background color, clip actions
-        }
-        else if( m_header.code == TagCode::REMOVE_OBJECT )
-        {
-            stream.read_uint16();
-            clip.erase(stream.read_uint16());
-        }
-        else if( m_header.code == TagCode::REMOVE_OBJECT2 )
-        {
-            clip.erase(stream.read_uint16());
-        }
-    }
+        block->set_origin(character_id, frame);
 
-    ActionPtr FrameAction::create(TagHeader header, BytesPtr bytes)
-    {
         auto action = new (std::nothrow) FrameAction();
         if( action )
         {
-            assert(header.code == TagCode::DO_ACTION);
-
             action->m_header = header;
-            action->m_bytes = std::move(bytes);
+            action->m_block = std::move(block);
             return ActionPtr(action);
         }
 
@@ -168,18 +64,25 @@ namespace openswf
     void FrameAction::execute(MovieClip& movie, MovieNode& node)
     {
         auto& vm = movie.get_player()->get_virtual_machine();
-        vm.execute(node.get_context(), m_bytes.get(), m_header.size);
+        vm.execute(node.get_context(), *m_block);
     }
 
+    const static uint16_t DefaultKeyframeInterval = 16;
+    // the fields of a placement always restored, as the node might be reused
+    const static uint8_t KeyframeMask =
+        PLACE_2_HAS_CHARACTER | PLACE_2_HAS_MATRIX | PLACE_2_HAS_CXFORM |
+        PLACE_2_HAS_RATIO | PLACE_2_HAS_CLIP_DEPTH;
+
     MovieClip::MovieClip(uint16_t cid, uint16_t frame_count, float frame_rate)
-    : m_character_id(cid), m_frame_rate(frame_rate)
+    : m_character_id(cid), m_frame_count(frame_count), m_frame_rate(frame_rate), m_loaded(false),
+    m_keyframe_interval(DefaultKeyframeInterval)
     {
         m_frames.reserve(frame_count);
     }
 
     INode* MovieClip::create_instance()
     {
-        return new MovieNode(m_player, this);
+        return m_player->get_node_pool().create<MovieNode>(m_player, this);
     }
 
     uint16_t MovieClip::get_character_id() const
@@ -195,7 +98,8 @@ namespace openswf
         auto& frame = m_frames[index];
         if( mask & FRAME_COMMANDS )
         {
-            for( auto& command : frame.commands )
+            auto command = m_commands.data() + frame.command_start;
+            for( uint32_t i=0; i<frame.command_count; i++, command++ )
                 command->execute(*this, display);
         }
 
@@ -206,10 +110,120 @@ namespace openswf
         }
     }
 
+    const FrameCommand* MovieClip::get_frame_commands(uint16_t index, uint32_t& count) const
+    {
+        if( index >= m_frames.size() )
+        {
+            count = 0;
+            return nullptr;
+        }
+
+        count = m_frames[index].command_count;
+        return m_commands.data() + m_frames[index].command_start;
+    }
+
+    void MovieClip::set_keyframe_interval(uint16_t interval)
+    {
+        m_keyframe_interval = interval;
+        m_keyframes.clear();
+    }
+
+    typedef std::map<uint16_t, FrameCommand> PlacementMap;
+    // follows the same rules of MovieNode::set/get/erase
+    static void apply_command(PlacementMap& placements, const FrameCommand& command)
+    {
+        auto found = placements.find(command.depth);
+        if( command.type == FrameCommandType::REMOVE )
+        {
+            if( found != placements.end() ) placements.erase(found);
+            return;
+        }
+
+        if( command.mask & PLACE_2_HAS_CHARACTER )
+        {
+            if( found == placements.end() || found->second.character_id != command.character_id )
+            {
+                // a new node is created with default attributes
+                if( found != placements.end() ) placements.erase(found);
+
+                auto placement = FrameCommand(FrameCommandType::PLACE, command.depth);
+                placement.mask = KeyframeMask;
+                placement.character_id = command.character_id;
+                found = placements.insert(std::make_pair(command.depth, placement)).first;
+            }
+        }
+        else if( found == placements.end() )
+            return;
+
+        auto& placement = found->second;
+        if( command.mask & PLACE_2_HAS_MATRIX )
+            placement.matrix = command.matrix;
+
+        if( command.mask & PLACE_2_HAS_CXFORM )
+            placement.cxform = command.cxform;
+
+        if( command.mask & PLACE_2_HAS_RATIO )
+            placement.ratio = command.ratio;
+
+        if( command.mask & PLACE_2_HAS_NAME )
+        {
+            placement.mask |= PLACE_2_HAS_NAME;
+            placement.name = command.name;
+        }
+
+        if( command.mask & PLACE_2_HAS_CLIP_DEPTH )
+            placement.clip_depth = command.clip_depth;
+    }
+
+    const Keyframe* MovieClip::get_keyframe(uint16_t index)
+    {
+        if( m_keyframe_interval == 0 )
+            return nullptr;
+
+        // keyframes are built incrementally from the previous one,
+        // as far as the frames have been loaded.
+        uint32_t slot = index / m_keyframe_interval;
+        while( m_keyframes.size() <= slot )
+        {
+            uint32_t frame = m_keyframes.size() * m_keyframe_interval;
+            if( frame > m_frames.size() )
+                break;
+
+            PlacementMap placements;
+            uint32_t start = 0;
+            if( !m_keyframes.empty() )
+            {
+                auto& previous = m_keyframes.back();
+                for( auto& placement : previous.placements )
+                    placements.insert(std::make_pair(placement.depth, placement));
+                start = previous.frame;
+            }
+
+            for( auto i=start; i<frame; i++ )
+            {
+                auto command = m_commands.data() + m_frames[i].command_start;
+                for( uint32_t j=0; j<m_frames[i].command_count; j++, command++ )
+                    apply_command(placements, *command);
+            }
+
+            Keyframe keyframe;
+            keyframe.frame = frame;
+            keyframe.placements.reserve(placements.size());
+            for( auto& pair : placements )
+                keyframe.placements.push_back(pair.second);
+            m_keyframes.push_back(std::move(keyframe));
+        }
+
+        if( m_keyframes.empty() )
+            return nullptr;
+
+        return &m_keyframes[std::min<uint32_t>(slot, m_keyframes.size()-1)];
+    }
+
     ////
     MovieNode::MovieNode(Player* player, MovieClip* sprite)
     : INode(player, sprite),
-    m_sprite(sprite), m_frame_timer(0),
+    m_parent(nullptr), m_sprite(sprite), m_frame_timer(0),
     m_target_frame(1), m_current_frame(0), m_paused(false),
     m_context(nullptr)
     {
@@ -223,8 +237,13 @@ namespace openswf
     {
         m_player->get_virtual_machine().free_context(m_context);
 
+        auto& pool = m_player->get_node_pool();
+        for( auto& pair : m_deprecated )
+            pool.destroy(pair.second);
+        m_deprecated.clear();
+
         for( auto& pair : m_children )
-            delete pair.second;
+            pool.destroy(pair.second);
         m_children.clear();
     }
 
@@ -240,8 +259,17 @@ namespace openswf
                 {
                     m_frame_timer -= m_frame_delta;
 
-                    if( m_target_frame >= m_sprite->get_frame_count() )
+                    if( m_target_frame >= m_sprite->get_frames_loaded() )
+                    {
+                        // holds at the last loaded frame until more frames arrived
+                        if( !m_sprite->is_loaded() )
+                        {
+                            m_frame_timer = 0;
+                            break;
+                        }
+
                         m_target_frame = 0;
+                    }
                     m_target_frame ++;
                 }
             }
@@ -263,48 +291,117 @@ namespace openswf
     }
 
     // PROTECTED METHODS
-    static bool parse_path(const std::string& str, std::string& first, std::string& remaining)
+    // splits the next name of path, the leading slash is skipped.
+    // returns false if there is no more name.
+    static bool next_name(const char*& str, const char* end, const char*& name, size_t& size)
     {
-        if( str.empty() ) return false;
+        if( str == nullptr )
+            return false;
 
-        auto search_start = 0;
-        if( str[0] == '/' ) search_start = 1;
+        if( str < end && *str == '/' ) str++;
 
-        auto pos = str.find('/', search_start);
-        if( pos == std::string::npos ) return false;
+        auto separator = (const char*)memchr(str, '/', end-str);
+        name = str;
+        size = (separator == nullptr ? end : separator) - str;
+        str = separator == nullptr ? nullptr : separator + 1;
+        return true;
+    }
 
-        first = str.substr(search_start, pos-search_start);
-        remaining = str.substr(pos+1);
+    NodePath NodePath::create(AtomTable& atoms, const std::string& path)
+    {
+        NodePath result;
+        if( path.empty() )
+            return result;
+
+        auto str = path.c_str();
+        const char* name;
+        size_t size;
+        while( next_name(str, path.c_str()+path.size(), name, size) )
+        {
+            // an empty name matches nothing
+            if( size == 0 )
+            {
+                result.m_names.clear();
+                break;
+            }
 
-        return true;
+            result.m_names.push_back(atoms.intern(name, size));
+        }
+
+        return result;
     }
 
-    MovieNode* MovieNode::get(const std::string& name)
+    MovieNode* MovieNode::get(const std::string& path)
     {
-        if( name.empty() )
+        if( path.empty() )
             return nullptr;
 
-        std::string current, remaining;
-        if( parse_path(name, current, remaining) )
+        // names never interned are not used by any node
+        auto& atoms = m_player->get_atoms();
+        auto node = this;
+        auto str = path.c_str();
+        const char* name;
+        size_t size;
+        while( node != nullptr && next_name(str, path.c_str()+path.size(), name, size) )
         {
-            for( auto& pair : m_children )
-            {
-                auto clip = dynamic_cast<MovieNode*>(pair.second);
-                if( clip != nullptr && clip->get_name() == current )
-                    return clip->get(remaining);
-            }
+            auto atom = atoms.find(name, size);
+            if( atom.empty() ) return nullptr;
+            node = node->get_child(atom);
         }
-        else
+
+        return node;
+    }
+
+    MovieNode* MovieNode::get(const NodePath& path)
+    {
+        if( !path.is_valid() )
+            return nullptr;
+
+        auto node = this;
+        for( size_t i=0; i<path.size() && node != nullptr; i++ )
+            node = node->get_child(path.get(i));
+        return node;
+    }
+
+    void MovieNode::index_child(INode* child)
+    {
+        auto node = dynamic_cast<MovieNode*>(child);
+        if( node != nullptr && !node->m_name.empty() )
+            m_named_children.insert(std::make_pair(node->m_name, node));
+    }
+
+    void MovieNode::unindex_child(INode* child)
+    {
+        auto node = dynamic_cast<MovieNode*>(child);
+        if( node == nullptr || node->m_name.empty() )
+            return;
+
+        auto found = m_named_children.find(node->m_name);
+        if( found == m_named_children.end() || found->second != node )
+            return;
+
+        m_named_children.erase(found);
+
+        // another child might have the same name
+        for( auto& pair : m_children )
         {
-            for( auto& pair : m_children )
+            auto other = dynamic_cast<MovieNode*>(pair.second);
+            if( other != nullptr && other != node && other->m_name == node->m_name )
             {
-                auto clip = dynamic_cast<MovieNode*>(pair.second);
-                if( clip != nullptr && clip->get_name() == name )
-                    return clip;
+                m_named_children.insert(std::make_pair(other->m_name, other));
+                break;
             }
         }
+    }
 
-        return nullptr;
+    void MovieNode::set_name(Atom name)
+    {
+        if( m_name == name )
+            return;
+
+        if( m_parent != nullptr ) m_parent->unindex_child(this);
+        m_name = name;
+        if( m_parent != nullptr ) m_parent->index_child(this);
     }
 
     INode* MovieNode::get(uint16_t depth)
@@ -316,7 +413,8 @@ namespace openswf
         auto cache = m_deprecated.find(depth);
         if( cache != m_deprecated.end() )
         {
-            m_children[depth] = m_deprecated[depth];
+            m_children[depth] = cache->second;
+            index_child(cache->second);
             m_deprecated.erase(cache);
         }
 
@@ -334,7 +432,8 @@ namespace openswf
             }
             else
             {
-                delete iter->second;
+                unindex_child(iter->second);
+                m_player->get_node_pool().recycle(iter->second);
                 m_children.erase(iter);
             }
         }
@@ -342,28 +441,35 @@ namespace openswf
         auto cache = m_deprecated.find(depth);
         if( cache != m_deprecated.end() && cache->second->get_character_id() == cid )
         {
-            m_children[depth] = m_deprecated[depth];
+            auto instance = cache->second;
+            m_children[depth] = instance;
+            index_child(instance);
             m_deprecated.erase(cache);
-            return m_children[depth];
+            return instance;
         }
 
-        auto ch = m_player->get_character(cid);
-        if( ch != nullptr )
+        // reuses a instance of character removed recently
+        auto instance = m_player->get_node_pool().acquire(cid);
+        if( instance == nullptr )
         {
-            auto instance = ch->create_instance();
+            auto ch = m_player->get_character(cid);
+            if( ch == nullptr )
+                return nullptr;
 
-            auto node = dynamic_cast<MovieNode*>(instance);
-            if( node != nullptr )
-            {
-                node->set_parent(this);
-                node->set_context(m_player->get_virtual_machine().new_context(node));
-            }
+            instance = ch->create_instance();
+            if( instance == nullptr )
+                return nullptr;
+        }
 
-            m_children[depth] = instance;
-            return instance;
+        auto node = dynamic_cast<MovieNode*>(instance);
+        if( node != nullptr )
+        {
+            node->set_parent(this);
+            node->set_context(m_player->get_virtual_machine().new_context(node));
         }
 
-        return nullptr;
+        m_children[depth] = instance;
+        return instance;
     }
 
     void MovieNode::erase(uint16_t depth)
@@ -372,23 +478,36 @@ namespace openswf
         if( iter == m_children.end() )
             return;
 
-        delete iter->second;
+        unindex_child(iter->second);
+        m_player->get_node_pool().recycle(iter->second);
         m_children.erase(iter);
     }
 
     void MovieNode::reset()
     {
+        INode::reset();
+
         m_paused = false;
         m_target_frame = 1;
         m_current_frame = 0;
+        m_frame_timer = 0;
+        set_frame_rate(m_sprite->get_frame_rate());
 
+        m_parent = nullptr;
+
+        // a context is created once the node is placed again
+        m_player->get_virtual_machine().free_context(m_context);
+        m_context = nullptr;
+
+        auto& pool = m_player->get_node_pool();
         for( auto& pair : m_deprecated )
-            delete pair.second;
+            pool.recycle(pair.second);
         m_deprecated.clear();
 
         for( auto& pair : m_children )
-            delete pair.second;
+            pool.recycle(pair.second);
         m_children.clear();
+        m_named_children.clear();
     }
 
     void MovieNode::goto_frame(uint16_t frame, MovieGoto status, int offset)
@@ -415,22 +534,43 @@ namespace openswf
         if( frame == m_current_frame )
             return;
 
+        auto current = m_current_frame;
         if( m_current_frame > frame )
         {
             m_current_frame = 0;
             m_deprecated = std::move(m_children);
+            m_named_children.clear();
+
+            // restores the nearest keyframe instead of replaying from the first
+            // frame, nodes with the same character are reused as usual.
+            auto keyframe = m_sprite->get_keyframe(frame-1);
+            if( keyframe != nullptr )
+            {
+                for( auto& placement : keyframe->placements )
+                    placement.execute(*m_sprite, *this);
+                m_current_frame = keyframe->frame;
+            }
         }
 
-        auto mask = (FrameTaskMask)(FRAME_COMMANDS | FRAME_ACTIONS);
-        while(m_current_frame < frame &&
-              m_current_frame < m_sprite->get_frame_count())
+        // frames advanced over run their actions as usual. the frames replayed
+        // after a backward seek only update the display list, except the target
+        // one, so snapshots never change the scripts run.
+        auto last = std::min((int32_t)frame, m_sprite->get_frames_loaded());
+        while( m_current_frame < last )
         {
+            auto mask = m_current_frame >= current || m_current_frame+1 == last ?
+                (FrameTaskMask)(FRAME_COMMANDS | FRAME_ACTIONS) : FRAME_COMMANDS;
             m_sprite->execute(*this, m_current_frame++, mask);
         }
 
         if( m_deprecated.size() > 0 )
         {
-            for( auto& pair : m_deprecated ) delete pair.second;
+            auto& pool = m_player->get_node_pool();
+            for( auto& pair : m_deprecated )
+            {
+                unindex_child(pair.second);
+                pool.recycle(pair.second);
+            }
             m_deprecated.clear();
         }
     }
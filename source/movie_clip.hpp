@@ -2,8 +2,10 @@
 
 #include "types.hpp"
 #include "character.hpp"
+#include "display_list.hpp"
 #include "swf/record.hpp"
 #include "avm/value.hpp"
+#include "avm/action_block.hpp"
 
 #include <map>
 #include <unordered_map>
@@ -18,29 +20,76 @@ namespace openswf
     class ContextObject;
     }
 
-    class FrameCommand;
-    typedef std::unique_ptr<FrameCommand> CommandPtr;
-    typedef std::vector<CommandPtr> CommandList;
-    
-    class FrameCommand
+    enum PlaceObject2Mask
     {
-    protected:
-        TagHeader   m_header;
-        BytesPtr    m_bytes;
+        PLACE_2_HAS_MOVE            = 0x01,
+        PLACE_2_HAS_CHARACTER       = 0x02,
+        PLACE_2_HAS_MATRIX          = 0x04,
+        PLACE_2_HAS_CXFORM          = 0x08,
+        PLACE_2_HAS_RATIO           = 0x10,
+        PLACE_2_HAS_NAME            = 0x20,
+        PLACE_2_HAS_CLIP_DEPTH      = 0x40,
+        PLACE_2_HAS_CLIP_ACTIONS    = 0x80
+    };
 
-    public:
-        static CommandPtr create(TagHeader header, BytesPtr bytes);
-        virtual void execute(MovieClip&, MovieNode&);
+    enum PlaceObject3Mask
+    {
+        PLACE_3_HAS_FILTERS         = 0x01,
+        PLACE_3_HAS_BLEND_MODE      = 0x02,
+        PLACE_3_HAS_CACHE_AS_BITMAP = 0x04,
+        PLACE_3_HAS_CLASS_NAME      = 0x08,
+        PLACE_3_HAS_IMAGE           = 0x10,
+        PLACE_3_HAS_VISIBLE         = 0x20,
+        PLACE_3_OPAQUE_BACKGROUND   = 0x40,
+        PLACE_3_RESERVED_1          = 0x80,
+    };
+
+    enum class FrameCommandType : uint8_t
+    {
+        PLACE   = 0,
+        REMOVE  = 1
     };
 
+    // the PlaceObject/RemoveObject tags are decoded once when loading, and their
+    // records are stored contiguously by movie clip, so stepping frames does
+    // neither bit parsing nor allocation.
+    struct FrameCommand
+    {
+        FrameCommandType    type;
+        uint8_t             mask;           // PlaceObject2Mask
+        uint16_t            depth;
+        uint16_t            character_id;
+        uint16_t            ratio;
+        uint16_t            clip_depth;
+        uint16_t            name;           // index of names of movie clip
+        Matrix              matrix;
+        ColorTransform      cxform;
+
+        FrameCommand(FrameCommandType type, uint16_t depth)
+        : type(type), mask(0), depth(depth), character_id(0),
+        ratio(0), clip_depth(0), name(0) {}
+
+        void execute(MovieClip&, MovieNode&) const;
+    };
+
+    typedef std::vector<FrameCommand> CommandList;
+
     class FrameAction;
     typedef std::unique_ptr<FrameAction> ActionPtr;
     typedef std::vector<ActionPtr> ActionList;
 
-    class FrameAction : FrameCommand
+    // the actions of a DoAction tag, compiled once while parsing.
+    class FrameAction
     {
+    protected:
+        TagHeader           m_header;
+        avm::ActionBlockPtr m_block;
+
     public:
-        static ActionPtr create(TagHeader header, BytesPtr bytes);
+        // the block is attributed to the frame of movie clip by profiler,
+        // and optimized for the swf version of file.
+        static ActionPtr create(TagHeader header, const uint8_t* bytes, AtomTable& atoms,
+            int32_t version, uint16_t character_id, uint16_t frame);
         virtual void execute(MovieClip&, MovieNode&);
     };
 
@@ -52,8 +101,19 @@ namespace openswf
 
     struct MovieFrame
     {
-        CommandList commands;
+        uint32_t    command_start;  // range in the commands of movie clip
+        uint32_t    command_count;
         ActionList  actions;
+
+        MovieFrame() : command_start(0), command_count(0) {}
+    };
+
+    // the display list of a movie clip right before the frame is executed,
+    // restored by backward seeks which replays the remaining frames only.
+    struct Keyframe
+    {
+        uint16_t    frame;          // index of the frame about to be executed
+        CommandList placements;     // sorted by depth
     };
 
     class MovieClip : public ICharacter
@@ -63,10 +123,17 @@ namespace openswf
 
     protected:
         uint16_t                m_character_id;
+        uint16_t                m_frame_count;
         float                   m_frame_rate;
+        bool                    m_loaded;
 
         std::vector<MovieFrame> m_frames;
         NamedFrames             m_named_frames;
+        CommandList             m_commands;
+        std::vector<Atom>       m_names;
+
+        uint16_t                m_keyframe_interval;
+        std::vector<Keyframe>   m_keyframes;
 
     public:
         MovieClip(uint16_t cid, uint16_t frame_count, float frame_rate);
@@ -77,8 +144,22 @@ namespace openswf
         void    execute(MovieNode& display, uint16_t frame, FrameTaskMask mask);
 
         uint16_t    get_frame(const char*) const;
+        Atom        get_name(uint16_t index) const;
+        // the decoded display list commands of frame, index starts from 0
+        const FrameCommand* get_frame_commands(uint16_t index, uint32_t& count) const;
+
+        // snapshots are taken every interval frames on demand, 0 disables them.
+        void        set_keyframe_interval(uint16_t interval);
+        uint16_t    get_keyframe_interval() const;
+        // the latest keyframe at or before frame index, nullptr if not available.
+        const Keyframe* get_keyframe(uint16_t index);
         int32_t     get_frame_count() const;
         float       get_frame_rate() const;
+
+        // frames are available progressively while the swf file is loading,
+        // and a sprite is always loaded with its whole definition.
+        int32_t     get_frames_loaded() const;
+        bool        is_loaded() const;
     };
 
     inline uint16_t MovieClip::get_frame(const char* name) const
@@ -88,11 +169,32 @@ namespace openswf
         return found->second;
     }
 
+    inline Atom MovieClip::get_name(uint16_t index) const
+    {
+        return m_names[index];
+    }
+
+    inline uint16_t MovieClip::get_keyframe_interval() const
+    {
+        return m_keyframe_interval;
+    }
+
+    // the frame count declared by header
     inline int32_t MovieClip::get_frame_count() const
+    {
+        return m_frame_count;
+    }
+
+    inline int32_t MovieClip::get_frames_loaded() const
     {
         return m_frames.size();
     }
 
+    inline bool MovieClip::is_loaded() const
+    {
+        return m_loaded;
+    }
+
     inline float MovieClip::get_frame_rate() const
     {
         return m_frame_rate;
@@ -105,6 +207,21 @@ namespace openswf
         STOP        = 2
     };
 
+    // a target path of movie clips such as "a/b" or "/a/b", its names are
+    // interned once, so resolving it takes a hash probe per level only.
+    class NodePath
+    {
+    protected:
+        std::vector<Atom>   m_names;
+
+    public:
+        static NodePath create(AtomTable& atoms, const std::string& path);
+
+        bool    is_valid() const;
+        size_t  size() const;
+        Atom    get(size_t index) const;
+    };
+
     // A sprite corresponds to a movie clip in the Adobe Flash authoring application.
     // It is a SWF file contained within another SWF file, and supports many of the
     // features of a regular SWF file, such as the following:
@@ -114,13 +231,14 @@ namespace openswf
     class MovieNode : public INode
     {
     public:
-        typedef std::map<uint16_t, INode*>      DisplayList;
         typedef std::weak_ptr<MovieNode>    WeakPtr;
         typedef std::shared_ptr<MovieNode>  SharedPtr;
 
     protected:
         DisplayList     m_children;
         DisplayList     m_deprecated;
+        // the named movie clips of children, duplicated names resolve to one of them
+        std::unordered_map<Atom, MovieNode*> m_named_children;
 
         MovieNode*              m_parent;
         MovieClip*              m_sprite;
@@ -145,11 +263,15 @@ namespace openswf
 
         INode*      set(uint16_t depth, uint16_t cid);
         INode*      get(uint16_t depth);
-        MovieNode*  get(const std::string& name);
+        MovieNode*  get(const std::string& path);
+        MovieNode*  get(const NodePath& path);
+        MovieNode*  get_child(Atom name);
         void        erase(uint16_t depth);
         MovieNode*  get_parent() const;
 
-        void reset();
+        virtual void reset();
+        virtual void set_name(Atom name);
+        using INode::set_name;
         void set_status(MovieGoto status);
         void set_context(avm::ContextObject*);
         avm::ContextObject* get_context();
@@ -168,9 +290,33 @@ namespace openswf
     protected:
         void step_to_frame(uint16_t frame);
         void set_parent(MovieNode*);
+        void index_child(INode*);
+        void unindex_child(INode*);
     };
 
     /// INLINE METHODS
+    inline bool NodePath::is_valid() const
+    {
+        return !m_names.empty();
+    }
+
+    inline size_t NodePath::size() const
+    {
+        return m_names.size();
+    }
+
+    inline Atom NodePath::get(size_t index) const
+    {
+        return m_names[index];
+    }
+
+    inline MovieNode* MovieNode::get_child(Atom name)
+    {
+        auto found = m_named_children.find(name);
+        if( found == m_named_children.end() ) return nullptr;
+        return found->second;
+    }
+
     inline void MovieNode::set_parent(MovieNode* parent)
     {
         m_parent = parent;
@@ -0,0 +1,118 @@
+#include "node_pool.hpp"
+#include "character.hpp"
+
+namespace openswf
+{
+    // the size class of blocks which are allocated from heap directly
+    const static size_t LargeBlock = 0xFFFF;
+
+    NodePool::NodePool()
+    : m_recycled_count(0)
+    {
+        for( size_t i=0; i<SizeClasses; i++ )
+            m_free_blocks[i] = nullptr;
+    }
+
+    NodePool::~NodePool()
+    {
+        clear();
+    }
+
+    void* NodePool::allocate(size_t size)
+    {
+        auto index = (size + Granularity - 1) / Granularity - 1;
+        if( index >= SizeClasses )
+        {
+            auto block = new (std::nothrow) uint8_t[HeaderSize + size];
+            if( block == nullptr ) return nullptr;
+
+            *(size_t*)block = LargeBlock;
+            return block + HeaderSize;
+        }
+
+        if( m_free_blocks[index] == nullptr )
+        {
+            // carves a new slab into blocks of this size class
+            auto block_size = HeaderSize + (index+1) * Granularity;
+            auto slab = new (std::nothrow) uint8_t[block_size * BlocksPerSlab];
+            if( slab == nullptr ) return nullptr;
+
+            m_slabs.push_back(BytesPtr(slab));
+            for( size_t i=0; i<BlocksPerSlab; i++ )
+            {
+                auto block = slab + i * block_size;
+                *(size_t*)block = index;
+
+                auto free = (FreeBlock*)(block + HeaderSize);
+                free->next = m_free_blocks[index];
+                m_free_blocks[index] = free;
+            }
+        }
+
+        auto free = m_free_blocks[index];
+        m_free_blocks[index] = free->next;
+        return free;
+    }
+
+    void NodePool::deallocate(void* ptr)
+    {
+        auto block = (uint8_t*)ptr - HeaderSize;
+        auto index = *(size_t*)block;
+        if( index == LargeBlock )
+        {
+            delete[] block;
+            return;
+        }
+
+        auto free = (FreeBlock*)ptr;
+        free->next = m_free_blocks[index];
+        m_free_blocks[index] = free;
+    }
+
+    void NodePool::destroy(INode* node)
+    {
+        if( node == nullptr ) return;
+
+        node->~INode();
+        deallocate(node);
+    }
+
+    INode* NodePool::acquire(uint16_t cid)
+    {
+        auto found = m_recycled.find(cid);
+        if( found == m_recycled.end() || found->second.empty() )
+            return nullptr;
+
+        auto node = found->second.back();
+        found->second.pop_back();
+        m_recycled_count --;
+        return node;
+    }
+
+    void NodePool::recycle(INode* node)
+    {
+        if( node == nullptr ) return;
+
+        if( m_recycled_count >= MaxRecycled )
+        {
+            destroy(node);
+            return;
+        }
+
+        node->reset();
+        m_recycled[node->get_character_id()].push_back(node);
+        m_recycled_count ++;
+    }
+
+    void NodePool::clear()
+    {
+        for( auto& pair : m_recycled )
+        {
+            for( auto node : pair.second )
+                destroy(node);
+        }
+
+        m_recycled.clear();
+        m_recycled_count = 0;
+    }
+}
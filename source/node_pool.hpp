@@ -0,0 +1,82 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace openswf
+{
+    class INode;
+
+    // display nodes of a player are allocated from slabs of fixed size blocks,
+    // and the nodes removed from display lists are kept by character id, so
+    // placing a character which was removed recently takes no allocation.
+    // its not thread-safe, nodes are created and destroyed by the player only.
+    class NodePool
+    {
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        const static size_t Granularity     = 16;
+        const static size_t MaxBlockSize    = 512;
+        const static size_t SizeClasses     = MaxBlockSize / Granularity;
+        const static size_t BlocksPerSlab   = 32;
+        // the size class is stored in front of block, keeping the alignment
+        const static size_t HeaderSize      = 16;
+        const static size_t MaxRecycled     = 1024;
+
+        typedef std::unordered_map<uint16_t, std::vector<INode*>> RecycledNodes;
+
+    protected:
+        std::vector<BytesPtr>   m_slabs;
+        FreeBlock*              m_free_blocks[SizeClasses];
+        RecycledNodes           m_recycled;
+        size_t                  m_recycled_count;
+
+    public:
+        NodePool();
+        ~NodePool();
+
+        template<typename T, typename ... Args> T* create(Args&& ... args);
+        void    destroy(INode*);
+
+        // returns a recycled node of character with its attributes reset,
+        // or nullptr if there is none.
+        INode*  acquire(uint16_t cid);
+        // resets and keeps the node for later use, or destroys it if
+        // the pool is full.
+        void    recycle(INode*);
+        // destroys all the recycled nodes
+        void    clear();
+
+        size_t  get_recycled_count() const;
+        size_t  get_slab_count() const;
+
+    protected:
+        void*   allocate(size_t size);
+        void    deallocate(void* ptr);
+    };
+
+    /// INLINE METHODS
+    template<typename T, typename ... Args> T* NodePool::create(Args&& ... args)
+    {
+        auto memory = allocate(sizeof(T));
+        if( memory == nullptr ) return nullptr;
+        return new (memory) T(std::forward<Args>(args)...);
+    }
+
+    inline size_t NodePool::get_recycled_count() const
+    {
+        return m_recycled_count;
+    }
+
+    inline size_t NodePool::get_slab_count() const
+    {
+        return m_slabs.size();
+    }
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "stream.hpp"
+#include "file_source.hpp"
 #include "player.hpp"
 #include "shader.hpp"
 
@@ -9,6 +10,7 @@
 #include "movie_clip.hpp"
 
 #include "swf/parser.hpp"
+#include "swf/tag_index.hpp"
 
 // SWF 6 and Later compatiable
 // FEAT, FIX, DOCS, STYLE, REFINE, TEST, CHORE
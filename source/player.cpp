@@ -3,27 +3,35 @@
 #include "shape.hpp"
 #include "stream.hpp"
 #include "render.hpp"
+#include "file_source.hpp"
 
 #include "swf/parser.hpp"
+#include "swf/decompressor.hpp"
+#include "swf/tag_index.hpp"
 #include "avm/avm.hpp"
 #include "avm/virtual_machine.hpp"
 
+#include <algorithm>
 #include <ctime>
 
 namespace openswf
 {
     const static int        MaxRecursionDepth = 256;
-    const static float      TimeoutSeconds = 0.1f;
+    const static uint16_t   TimeoutSeconds = 15;
     const static uint32_t   ClocksPerMs = CLOCKS_PER_SEC * 0.001;
+    const static uint32_t   HeaderSize = 8;
 
     Player::Player()
-    : m_version(10),
-    m_avm(nullptr), m_script_max_recursion(MaxRecursionDepth), m_script_timeout(TimeoutSeconds)
+    : m_sprite(nullptr), m_root(nullptr), m_version(10),
+    m_script_max_recursion(MaxRecursionDepth), m_script_timeout(TimeoutSeconds),
+    m_options(0), m_lazy_characters(0), m_avm(nullptr), m_context(nullptr),
+    m_available(0), m_received_all(false)
     {}
 
-    Player* Player::create(Stream& stream)
+    Player* Player::create(Stream& stream, uint32_t options)
     {
         auto player = new (std::nothrow) Player();
+        if( player ) player->m_options = options;
         if( player && player->initialize(stream) )
             return player;
 
@@ -31,10 +39,133 @@ namespace openswf
         return nullptr;
     }
 
+    Player* Player::create_from_file(const char* path, uint32_t options)
+    {
+        auto source = FileSource::create(path);
+        if( source == nullptr )
+            return nullptr;
+
+        auto player = new (std::nothrow) Player();
+        if( player == nullptr )
+            return nullptr;
+
+        // tags are scanned once from the beginning to the end
+        player->m_options = options;
+        source->advise(FileAccess::SEQUENTIAL);
+        player->m_source = std::move(source);
+
+        auto stream = player->m_source->get_stream();
+        if( player->initialize(stream) )
+        {
+            // definitions are decoded on demand in lazy mode
+            player->m_source->advise( (options & LOAD_LAZY_CHARACTERS) ?
+                FileAccess::RANDOM : FileAccess::NORMAL );
+            return player;
+        }
+
+        delete player;
+        return nullptr;
+    }
+
+    Player* Player::create(uint32_t options)
+    {
+        auto player = new (std::nothrow) Player();
+        if( player ) player->m_options = options;
+        return player;
+    }
+
     bool Player::initialize(Stream& stream)
     {
         stream.set_position(0);
-        auto header = SWFHeader::read(stream);
+        m_stream = stream;
+        m_available = stream.get_size();
+        m_received_all = true;
+
+        // tags of compressed file are inflated progressively while parsing
+        m_decompressor = Decompressor::create(m_stream);
+        if( !initialize_header() )
+            return false;
+
+        parse();
+        return true;
+    }
+
+    bool Player::load(const uint8_t* bytes, uint32_t size)
+    {
+        // trailing bytes, eg. checksum of compressed stream, are ignored
+        if( is_loaded() )
+            return true;
+
+        // the leading 8 bytes tell the compression and length of file
+        if( m_received.size() < HeaderSize )
+        {
+            m_received.insert(m_received.end(), bytes, bytes+size);
+            if( m_received.size() < HeaderSize )
+                return true;
+
+            auto signature = m_received[0];
+            if( (signature != 'F' && signature != 'C' && signature != 'Z') ||
+                m_received[1] != 'W' || m_received[2] != 'S' )
+            {
+                LWARNING(LOG_LOADER, "bytes loaded are not a swf file.\n");
+                m_received.clear();
+                return false;
+            }
+
+            m_stream = Stream(m_received.data(), m_received.size());
+            m_decompressor = Decompressor::create(m_stream);
+            if( m_decompressor == nullptr )
+            {
+                // uncompressed bytes are parsed in place, the buffer must not
+                // be moved once the stream is created.
+                m_stream.set_position(4);
+                auto length = m_stream.read_uint32();
+                if( m_received.size() > length )
+                    m_received.resize(length);
+                m_stream = Stream(m_received.data(), length);
+            }
+        }
+        else if( m_decompressor == nullptr )
+        {
+            // the length in header is not trusted to reserve the buffer, its
+            // grown as bytes arrive, and moving it waits for the workers reading.
+            auto remaining = m_stream.get_size() - (uint32_t)m_received.size();
+            auto count = std::min(size, remaining);
+            if( m_received.size() + count > m_received.capacity() )
+                publish_pending();
+
+            m_received.insert(m_received.end(), bytes, bytes+count);
+
+            auto position = m_stream.get_position();
+            m_stream = Stream(m_received.data(), m_stream.get_size());
+            m_stream.set_position(position);
+        }
+        else
+            m_received.insert(m_received.end(), bytes, bytes+size);
+
+        if( m_decompressor != nullptr )
+            m_decompressor->set_source(m_received.data(), m_received.size());
+        m_available = std::min((uint32_t)m_received.size(), m_stream.get_size());
+
+        if( m_sprite == nullptr && !initialize_header() )
+            return true;
+
+        parse();
+        return true;
+    }
+
+    bool Player::initialize_header()
+    {
+        auto& source = get_source_stream();
+        if( !is_available(HeaderSize+1) )
+            return false;
+
+        source.set_position(0);
+        if( !is_available(SWFHeader::get_length(source.get_current_ptr()[HeaderSize])) )
+            return false;
+
+        auto header = SWFHeader::read(source);
+        m_header = header;
 
         m_sprite = new (std::nothrow) MovieClip(0, header.frame_count, header.frame_rate);
         m_sprite->set_player(this);
@@ -43,29 +174,146 @@ namespace openswf
         m_version = header.version;
         m_start_ms = clock() / ClocksPerMs;
 
-        auto env = Environment(stream, *this, header);
+        m_root = m_node_pool.create<MovieNode>(this, m_sprite);
+        m_root->set_name("_level0");
+
+        m_avm = new (std::nothrow) avm::VirtualMachine(m_atoms, m_version);
+        m_context = m_avm->new_context(m_root);
+        m_avm->set_script_limits(m_script_max_recursion, m_script_timeout);
+        m_avm->set_profiling((m_options & SCRIPT_PROFILE) != 0);
+
+        if( m_options & LOAD_PROFILE )
+            m_profiler.reset(new (std::nothrow) LoadProfiler());
+
+        m_tag_index = TagIndex::create();
+        m_environment.reset(new (std::nothrow) Environment(source, *this, header));
+        m_environment->options = m_options;
+        return true;
+    }
+
+    void Player::parse()
+    {
+        auto& env = *m_environment;
         while( env.advance() )
         {
-            if( env.movie == m_sprite )
-                printf("%s %d\n", Parser::to_string(env.tag.code), env.tag.size);
-            else
-                printf("\t%s %d\n", Parser::to_string(env.tag.code), env.tag.size);
+            LTRACE(LOG_LOADER, "%s%s %d\n", env.movie == m_sprite ? "" : "\t",
+                Parser::to_string(env.tag.code), env.tag.size);
 
             if( !Parser::execute(env) )
-                printf("[WARN] tag %s has not defined handler.\n",
+                LWARNING(LOG_LOADER, "tag %s has not defined handler.\n",
                     Parser::to_string(env.tag.code));
         }
 
-        m_root = new (std::nothrow) MovieNode(this, m_sprite);
-        m_root->set_name("_level0");
+        if( env.finished )
+        {
+            publish_pending();
+            m_environment.reset();
+        }
+    }
 
-        m_avm = new (std::nothrow) avm::VirtualMachine(m_version);
-        m_context = m_avm->new_context(m_root);
-        return true;
+    bool Player::is_available(uint32_t position)
+    {
+        if( m_decompressor != nullptr )
+            return m_decompressor->advance(position);
+        return position <= m_available;
+    }
+
+    bool Player::is_source_ended() const
+    {
+        if( m_decompressor != nullptr && m_decompressor->is_finished() )
+            return true;
+        return m_received_all;
+    }
+
+    Stream& Player::get_source_stream()
+    {
+        return m_decompressor ? m_decompressor->get_stream() : m_stream;
+    }
+
+    void Player::defer_character(uint16_t cid, std::future<ICharacter*> future)
+    {
+        m_pending.push_back({ cid, std::move(future) });
+    }
+
+    void Player::publish_pending(int32_t cid)
+    {
+        auto count = m_pending.size();
+        if( cid >= 0 )
+        {
+            auto found = std::find_if(m_pending.begin(), m_pending.end(),
+                [=](const PendingCharacter& pending) { return pending.cid == cid; });
+
+            if( found == m_pending.end() )
+                return;
+            count = found - m_pending.begin() + 1;
+        }
+
+        // published in tag order, so the result is deterministic. its popped
+        // before attached, as attaching might look up other characters.
+        for( size_t i=0; i<count; i++ )
+        {
+            auto pending = std::move(m_pending.front());
+            m_pending.pop_front();
+
+            auto ch = pending.future.get();
+            if( ch != nullptr )
+                set_character(pending.cid, ch);
+        }
+    }
+
+    ICharacter* Player::resolve_character(ICharacter* ch)
+    {
+        auto stub = dynamic_cast<LazyCharacter*>(ch);
+        if( stub == nullptr )
+            return ch;
+
+        auto cid = stub->get_character_id();
+        m_dictionary.erase(cid);
+        m_lazy_characters --;
+        delete stub;
+
+        auto tag = m_tag_index->get_character(cid);
+        assert( tag != nullptr );
+
+        // runs the handler of definition as if its parsed just now
+        auto stream = get_source_stream();
+        stream.set_position(tag->offset);
+
+        auto env = Environment(stream, *this, m_header);
+        env.tag.code    = tag->code;
+        env.tag.size    = tag->size;
+        env.tag.end_pos = tag->offset + tag->size;
+        Parser::execute(env);
+
+        auto found = m_dictionary.find(cid);
+        if( found != m_dictionary.end() )
+            return found->second;
+        return nullptr;
+    }
+
+    LoadReport Player::get_load_report()
+    {
+        if( m_profiler == nullptr )
+            return LoadReport();
+
+        // workers are writing the costs of pending characters
+        publish_pending();
+        return m_profiler->get_report();
+    }
+
+    avm::ScriptReport Player::get_script_report()
+    {
+        if( m_avm == nullptr || m_avm->get_profiler() == nullptr )
+            return avm::ScriptReport();
+
+        return m_avm->get_profiler()->get_report();
     }
 
     Player::~Player()
     {
+        // workers might be reading the bytes of file
+        publish_pending();
+
         for( auto& pair : m_dictionary )
             delete pair.second;
         m_dictionary.clear();
@@ -78,10 +326,13 @@ namespace openswf
 
         if( m_root != nullptr )
         {
-            delete m_root;
+            m_node_pool.destroy(m_root);
             m_root = nullptr;
         }
 
+        // recycled movie nodes are referring the virtual machine
+        m_node_pool.clear();
+
         if( m_avm != nullptr )
         {
             delete m_avm;
@@ -92,11 +343,26 @@ namespace openswf
 
     void Player::update(float dt)
     {
-        m_root->update(dt);
+        // blocks suspended in last frame are finished before this one
+        if( m_avm != nullptr )
+            m_avm->update();
+
+        if( m_root != nullptr )
+            m_root->update(dt);
+
+        // the garbage of scripts is collected a little every frame
+        if( m_avm != nullptr )
+            m_avm->collect();
+
+        // logging of this frame is written out once
+        Logger::get_instance().flush();
     }
 
     void Player::render()
     {
+        if( m_root == nullptr )
+            return;
+
         Render::get_instance().clear(CLEAR_COLOR | CLEAR_DEPTH,
             m_background.r, m_background.g, m_background.b, m_background.a);
         m_root->render(Matrix::identity, ColorTransform::identity);
@@ -105,6 +371,7 @@ namespace openswf
     void Player::set_character(uint16_t cid, ICharacter* ch)
     {
         assert( ch != nullptr );
+
         ch->set_player(this);
         m_dictionary[cid] = ch;
     }
@@ -2,23 +2,57 @@
 
 #include "debug.hpp"
 #include "types.hpp"
+#include "stream.hpp"
 #include "movie_clip.hpp"
+#include "node_pool.hpp"
+#include "profiler.hpp"
 #include "avm/avm.hpp"
+#include "avm/script_profiler.hpp"
 
+#include <deque>
+#include <future>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace openswf
 {
     class ICharacter;
-    class Stream;
     class Parser;
+    class Decompressor;
+    class FileSource;
+    class TagIndex;
+    struct Environment;
+
+    enum LoadOptionMask
+    {
+        // definitions of shapes and bitmaps are registered as stubs, which are
+        // decoded on the first use. the bytes of file are kept by player.
+        LOAD_LAZY_CHARACTERS    = 0x1,
+        // bitmaps and shapes are decoded by the worker threads while parsing,
+        // and published into dictionary in the order of tags.
+        LOAD_PARALLEL           = 0x2,
+        // the time and memory taken by each tag and character are recorded,
+        // see Player::get_load_report.
+        LOAD_PROFILE            = 0x4,
+        // the cycles taken by each action and each block of frame scripts
+        // are recorded, see Player::get_script_report.
+        SCRIPT_PROFILE          = 0x8
+    };
+
     class Player
     {
         friend class Parser;
+        friend struct Environment;
         typedef std::unordered_map<uint16_t, ICharacter*> Directory;
         typedef std::unordered_map<std::string, uint16_t> ExportedAssets;
 
+        struct PendingCharacter
+        {
+            uint16_t                    cid;
+            std::future<ICharacter*>    future;
+        };
+
     protected:
         Directory       m_dictionary;
         ExportedAssets  m_exported_assets;
@@ -26,22 +60,85 @@ namespace openswf
         MovieClip*      m_sprite;
         Rect            m_size;
         MovieNode*      m_root;
+        NodePool        m_node_pool;
+        AtomTable       m_atoms;
         Color           m_background;
         uint8_t         m_version;
         uint16_t        m_script_max_recursion, m_script_timeout;
         uint32_t        m_start_ms;
+        uint32_t        m_options;
+        uint32_t        m_lazy_characters;
+        SWFHeader       m_header;
+
+        std::deque<PendingCharacter>    m_pending;  // decoding by workers
 
         avm::VirtualMachine*    m_avm;
         avm::ContextObject*     m_context;
 
+        std::unique_ptr<FileSource>     m_source;
+        std::unique_ptr<Decompressor>   m_decompressor;
+        std::unique_ptr<Environment>    m_environment;  // alive while loading
+        std::unique_ptr<TagIndex>       m_tag_index;    // built as tags arrive
+        std::unique_ptr<LoadProfiler>   m_profiler;     // with LOAD_PROFILE
+        std::vector<uint8_t>            m_received;     // bytes fed by load()
+        Stream                          m_stream;
+        uint32_t                        m_available;
+        bool                            m_received_all; // no more bytes to load
+
     protected:
         Player();
         bool initialize(Stream& stream);
+        bool initialize_header();
+        void parse();
+
+        // returns true if bytes in range [0, position) of the uncompressed
+        // file have been received, compressed bytes are inflated on demand.
+        bool is_available(uint32_t position);
+        // returns true if no more bytes would be received, the whole file is
+        // in memory, or the compressed stream has ended or is corrupted.
+        bool is_source_ended() const;
+        Stream& get_source_stream();
+
+        // decodes the definition if its a stub, returns the real character.
+        ICharacter* resolve_character(ICharacter* ch);
+
+        // the character would be published once its decoded by worker thread.
+        void defer_character(uint16_t cid, std::future<ICharacter*> future);
+        // publishes the pending characters in tag order, until the character
+        // of cid if its pending, or all of them if cid is negative.
+        void publish_pending(int32_t cid = -1);
 
     public:
-        static Player* create(Stream& stream);
+        // both uncompressed and compressed(CWS, ZWS) files are accepted,
+        // the bytes of stream must be valid until this function returns,
+        // or during the life of player with LOAD_LAZY_CHARACTERS.
+        static Player* create(Stream& stream, uint32_t options = 0);
+        // the file is mapped into memory and owned by player.
+        static Player* create_from_file(const char* path, uint32_t options = 0);
+        // creates an empty player, the bytes of swf file are fed by load()
+        // progressively, and the root movie is available once the header arrived.
+        static Player* create(uint32_t options = 0);
         ~Player();
 
+        // parses all the tags which have been received completely, returns false
+        // if the bytes are not a swf file. bytes following the end of file are ignored.
+        bool        load(const uint8_t* bytes, uint32_t size);
+        uint16_t    get_frames_loaded() const;
+        bool        is_loaded() const;
+
+        // the index of tags received so far, returns nullptr until the header arrived.
+        const TagIndex* get_tag_index() const;
+        // the number of characters which have not been decoded yet.
+        uint32_t        get_lazy_characters() const;
+        // the costs of tags and characters handled so far, its empty unless
+        // created with LOAD_PROFILE. characters decoded lazily are included
+        // once used, and pending ones of LOAD_PARALLEL are waited for.
+        LoadReport      get_load_report();
+        LoadProfiler*   get_load_profiler();
+        // the costs of scripts executed so far, its empty unless created
+        // with SCRIPT_PROFILE.
+        avm::ScriptReport   get_script_report();
+
         void update(float dt);
         void render();
 
@@ -70,15 +167,24 @@ namespace openswf
         MovieClip&              get_root_def();
         MovieNode&              get_root();
         avm::VirtualMachine&    get_virtual_machine();
+        NodePool&               get_node_pool();
+        // the instance names of nodes
+        AtomTable&              get_atoms();
     };
 
     //// INLINE METHODS of PLAYER
     inline ICharacter* Player::get_character(uint16_t cid)
     {
+        if( !m_pending.empty() )
+            publish_pending(cid);
+
         auto found = m_dictionary.find(cid);
-        if( found != m_dictionary.end() )
-            return found->second;
-        return nullptr;
+        if( found == m_dictionary.end() )
+            return nullptr;
+
+        if( m_lazy_characters > 0 )
+            return resolve_character(found->second);
+        return found->second;
     }
 
     inline ICharacter* Player::get_character(const std::string& name)
@@ -89,6 +195,31 @@ namespace openswf
         return nullptr;
     }
 
+    inline uint16_t Player::get_frames_loaded() const
+    {
+        return m_sprite ? m_sprite->get_frames_loaded() : 0;
+    }
+
+    inline bool Player::is_loaded() const
+    {
+        return m_sprite && m_sprite->is_loaded();
+    }
+
+    inline const TagIndex* Player::get_tag_index() const
+    {
+        return m_tag_index.get();
+    }
+
+    inline uint32_t Player::get_lazy_characters() const
+    {
+        return m_lazy_characters;
+    }
+
+    inline LoadProfiler* Player::get_load_profiler()
+    {
+        return m_profiler.get();
+    }
+
     inline const Color& Player::get_background_color() const
     {
         return m_background;
@@ -128,4 +259,14 @@ namespace openswf
     {
         return *m_avm;
     }
+
+    inline NodePool& Player::get_node_pool()
+    {
+        return m_node_pool;
+    }
+
+    inline AtomTable& Player::get_atoms()
+    {
+        return m_atoms;
+    }
 }
\ No newline at end of file
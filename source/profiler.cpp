@@ -0,0 +1,154 @@
+#include "profiler.hpp"
+
+#include <chrono>
+#include <cstring>
+
+namespace openswf
+{
+    static thread_local CharacterCost* s_current = nullptr;
+
+    uint64_t LoadProfiler::now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void LoadProfiler::add_tag(const TagHeader& tag, uint32_t consumed, uint64_t nanoseconds)
+    {
+        auto found = m_tags.find((uint32_t)tag.code);
+        if( found == m_tags.end() )
+        {
+            TagCost cost;
+            memset(&cost, 0, sizeof(cost));
+            cost.code = tag.code;
+            found = m_tags.insert(std::make_pair((uint32_t)tag.code, cost)).first;
+        }
+
+        found->second.count ++;
+        found->second.bytes_consumed += consumed;
+        found->second.nanoseconds += nanoseconds;
+    }
+
+    CharacterCost* LoadProfiler::add_character(uint16_t cid, const TagHeader& tag)
+    {
+        m_characters.emplace_back();
+
+        auto& cost = m_characters.back();
+        memset(&cost, 0, sizeof(cost));
+        cost.cid = cid;
+        cost.code = tag.code;
+        cost.bytes_consumed = tag.size;
+
+        m_character_index[cid] = &cost;
+        return &cost;
+    }
+
+    CharacterCost* LoadProfiler::find_character(uint16_t cid)
+    {
+        auto found = m_character_index.find(cid);
+        return found != m_character_index.end() ? found->second : nullptr;
+    }
+
+    LoadReport LoadProfiler::get_report() const
+    {
+        LoadReport report;
+
+        auto tags = m_tags;
+        for( auto& character : m_characters )
+        {
+            auto& cost = tags[(uint32_t)character.code];
+            cost.code = character.code;
+            cost.bytes_allocated += character.bytes_allocated;
+            cost.decode_nanoseconds += character.nanoseconds;
+            for( auto i=0; i<LOAD_PHASE_COUNT; i++ )
+                cost.phases[i] += character.phases[i];
+        }
+
+        report.tags.reserve(tags.size());
+        for( auto& pair : tags )
+            report.tags.push_back(pair.second);
+
+        std::sort(report.tags.begin(), report.tags.end(),
+            [](const TagCost& a, const TagCost& b) { return a.code < b.code; });
+
+        // the time of phases after decoding, eg. texture upload, counts too
+        auto total = [](const CharacterCost& cost)
+        {
+            return cost.nanoseconds + cost.phases[LOAD_PHASE_TEXTURE_UPLOAD];
+        };
+
+        report.characters.assign(m_characters.begin(), m_characters.end());
+        std::stable_sort(report.characters.begin(), report.characters.end(),
+            [&](const CharacterCost& a, const CharacterCost& b) { return total(a) > total(b); });
+
+        return report;
+    }
+
+    const char* LoadReport::to_string(LoadPhase phase)
+    {
+        switch(phase)
+        {
+        case LOAD_PHASE_PARSE_BITS:     return "PARSE_BITS";
+        case LOAD_PHASE_CONTOURS:       return "CONTOURS";
+        case LOAD_PHASE_TESSELLATE:     return "TESSELLATE";
+        case LOAD_PHASE_INFLATE:        return "INFLATE";
+        case LOAD_PHASE_JPEG_DECODE:    return "JPEG_DECODE";
+        case LOAD_PHASE_TEXTURE_UPLOAD: return "TEXTURE_UPLOAD";
+        default:
+            return "undefined";
+        }
+    }
+
+    ProfileScope::ProfileScope(CharacterCost* record)
+    : m_record(record), m_phase(LOAD_PHASE_COUNT)
+    {
+        start();
+    }
+
+    ProfileScope::ProfileScope(CharacterCost* record, LoadPhase phase)
+    : m_record(record), m_phase(phase)
+    {
+        start();
+    }
+
+    ProfileScope::ProfileScope(LoadPhase phase)
+    : m_record(s_current), m_phase(phase)
+    {
+        start();
+    }
+
+    void ProfileScope::start()
+    {
+        if( m_record == nullptr )
+            return;
+
+        m_previous = s_current;
+        s_current = m_record;
+        m_start = LoadProfiler::now();
+    }
+
+    ProfileScope::~ProfileScope()
+    {
+        if( m_record == nullptr )
+            return;
+
+        auto elapsed = LoadProfiler::now() - m_start;
+        if( m_phase == LOAD_PHASE_COUNT )
+            m_record->nanoseconds += elapsed;
+        else
+            m_record->phases[m_phase] += elapsed;
+
+        s_current = m_previous;
+    }
+
+    CharacterCost* ProfileScope::get_current()
+    {
+        return s_current;
+    }
+
+    void ProfileScope::count_allocation(size_t bytes)
+    {
+        if( s_current != nullptr )
+            s_current->bytes_allocated += bytes;
+    }
+}
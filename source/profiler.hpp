@@ -0,0 +1,103 @@
+#pragma once
+
+#include "types.hpp"
+#include "swf/record.hpp"
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace openswf
+{
+    enum LoadPhase
+    {
+        LOAD_PHASE_PARSE_BITS       = 0,    // styles and edge records of shapes
+        LOAD_PHASE_CONTOURS,                // assembling edges into contours of fills
+        LOAD_PHASE_TESSELLATE,
+        LOAD_PHASE_INFLATE,                 // zlib streams of bitmaps
+        LOAD_PHASE_JPEG_DECODE,
+        LOAD_PHASE_TEXTURE_UPLOAD,          // on first render, after decoding
+
+        LOAD_PHASE_COUNT
+    };
+
+    struct CharacterCost
+    {
+        uint16_t    cid;
+        TagCode     code;
+        uint32_t    bytes_consumed;     // size of definition tag
+        uint64_t    bytes_allocated;    // bitmaps, meshes and buffers of decoding
+        uint64_t    nanoseconds;        // decoding, on a worker with LOAD_PARALLEL
+        uint64_t    phases[LOAD_PHASE_COUNT];
+    };
+
+    struct TagCost
+    {
+        TagCode     code;
+        uint32_t    count;              // a lazy definition is executed twice
+        uint64_t    bytes_consumed;
+        uint64_t    bytes_allocated;    // by the characters defined
+        uint64_t    nanoseconds;        // in handlers, on the loading thread
+        uint64_t    decode_nanoseconds; // of the characters defined, on any thread
+        uint64_t    phases[LOAD_PHASE_COUNT];
+    };
+
+    struct LoadReport
+    {
+        std::vector<TagCost>        tags;       // ordered by tag code
+        std::vector<CharacterCost>  characters; // the most expensive first
+
+        static const char* to_string(LoadPhase phase);
+    };
+
+    // records the cost of every tag handled and every character decoded by a
+    // player created with LOAD_PROFILE. characters are added by the loading
+    // thread only, and each one is written by the thread decoding it.
+    class LoadProfiler
+    {
+        typedef std::unordered_map<uint32_t, TagCost> Tags;
+        typedef std::unordered_map<uint16_t, CharacterCost*> Characters;
+
+    protected:
+        Tags                        m_tags;
+        std::deque<CharacterCost>   m_characters;   // addresses are stable
+        Characters                  m_character_index;
+
+    public:
+        static uint64_t now();
+
+        void            add_tag(const TagHeader& tag, uint32_t consumed, uint64_t nanoseconds);
+        CharacterCost*  add_character(uint16_t cid, const TagHeader& tag);
+        CharacterCost*  find_character(uint16_t cid);
+
+        // its not safe while characters are being decoded by workers.
+        LoadReport      get_report() const;
+    };
+
+    // binds a character to the current thread while its decoded, so the
+    // phases and allocations deep in decoding are counted without passing
+    // the profiler around. everything is skipped if there is no character.
+    class ProfileScope
+    {
+    protected:
+        CharacterCost*  m_record;
+        CharacterCost*  m_previous;
+        LoadPhase       m_phase;
+        uint64_t        m_start;
+
+    public:
+        // the time elapsed is added to the decoding time of character.
+        explicit ProfileScope(CharacterCost* record);
+        // the time elapsed is added to the phase of character.
+        ProfileScope(CharacterCost* record, LoadPhase phase);
+        // the time elapsed is added to the phase of character being decoded.
+        explicit ProfileScope(LoadPhase phase);
+        ~ProfileScope();
+
+        static CharacterCost*   get_current();
+        static void             count_allocation(size_t bytes);
+
+    protected:
+        void start();
+    };
+}
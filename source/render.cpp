@@ -11,7 +11,7 @@ extern "C" {
     do { \
         GLenum err = glGetError(); \
         if( err != GL_NO_ERROR && err != GL_INVALID_ENUM ) { \
-            printf("GL_%s - %s:%d\n", get_opengl_error(err), __FILE__, __LINE__); \
+            LERROR(LOG_RENDER, "GL_%s - %s:%d\n", get_opengl_error(err), __FILE__, __LINE__); \
             assert(false); \
         } \
     } while(false);
@@ -757,9 +757,8 @@ namespace openswf
             GLint len;
             glGetShaderInfoLog(shader, 1024, &len, buf);
 
-            printf("compile failed:%s\n"
-                "source:\n %s\n",
-                buf, source);
+            LERROR(LOG_RENDER, "compile failed:%s\n", buf);
+            LDEBUG(LOG_RENDER, "source:\n %s\n", source);
             glDeleteShader(shader);
             return 0;
         }
@@ -803,7 +802,7 @@ namespace openswf
             char buf[1024];
             GLint len;
             glGetProgramInfoLog(prog, 1024, &len, buf);
-            printf("link failed:%s\n", buf);
+            LERROR(LOG_RENDER, "link failed:%s\n", buf);
             return 0;
         }
 
@@ -28,6 +28,8 @@ namespace openswf
 
         fill->m_texture_cid = cid;
         fill->m_bitmap = std::move(bitmap);
+        fill->m_image = nullptr;
+        fill->m_cost = nullptr;
         fill->m_texture_rid = 0;
 
         fill->m_additive_start = additive_start;
@@ -69,31 +71,39 @@ namespace openswf
         return create(cid, nullptr, Color::empty, Color::empty, start, end);
     }
 
-    void ShapeFill::attach(Player* env)
+    void ShapeFill::attach(Player* env, uint16_t cid)
     {
+        auto profiler = env->get_load_profiler();
+        m_cost = profiler ? profiler->find_character(cid) : nullptr;
+
         if( m_texture_cid != 0 ) // bitmap
         {
-            auto texture = env->get_character<Image>(m_texture_cid);
-            if( texture != nullptr )
-            {
-                m_coordinate.reset(0, texture->get_width(), 0, texture->get_height());
-                m_texture_rid = texture->get_texture_rid();
-            }
+            m_image = env->get_character<Image>(m_texture_cid);
+            if( m_image != nullptr )
+                m_coordinate.reset(0, m_image->get_width(), 0, m_image->get_height());
         }
 
         if( m_bitmap != nullptr ) // gradient
-        {
             m_coordinate.reset(-16384, 16384, -16384, 16384);
-            m_texture_rid = Render::get_instance().create_texture(
-                m_bitmap->get_ptr(),
-                m_bitmap->get_width(), m_bitmap->get_height(), m_bitmap->get_format(), 1);
-        }
 
         // solid
     }
 
-    Rid ShapeFill::get_bitmap() const
+    Rid ShapeFill::get_bitmap()
     {
+        if( m_texture_rid != 0 )
+            return m_texture_rid;
+
+        if( m_image != nullptr )
+            m_texture_rid = m_image->get_texture_rid();
+        else if( m_bitmap != nullptr )
+        {
+            ProfileScope scope(m_cost, LOAD_PHASE_TEXTURE_UPLOAD);
+            m_texture_rid = Render::get_instance().create_texture(
+                m_bitmap->get_ptr(),
+                m_bitmap->get_width(), m_bitmap->get_height(), m_bitmap->get_format(), 1);
+        }
+
         return m_texture_rid;
     }
 
@@ -162,6 +172,34 @@ namespace openswf
         return ShapeRecordPtr(record);
     }
 
+    // libtess2 keeps no global state, so a tesselator per thread is safe to be
+    // reused by all the shapes tesselated on the same thread, a new mesh is
+    // started by the first contour added after each tessTesselate.
+    class ThreadTesselator
+    {
+    protected:
+        TESStesselator* m_tess;
+
+    public:
+        ThreadTesselator() : m_tess(nullptr) {}
+        ~ThreadTesselator() { reset(); }
+
+        TESStesselator* get()
+        {
+            if( m_tess == nullptr ) m_tess = tessNewTess(nullptr);
+            return m_tess;
+        }
+
+        // the state of tesselator is unknown once failed
+        void reset()
+        {
+            if( m_tess != nullptr ) tessDeleteTess(m_tess);
+            m_tess = nullptr;
+        }
+    };
+
+    static thread_local ThreadTesselator s_tesselator;
+
     static bool tesselate(
         const PointList& vertices, const IndexList& contour_indices,
         ShapeFillList& fill_styles,
@@ -175,7 +213,7 @@ namespace openswf
         
         for( auto i=0; i<contour_indices.size(); i++ )
         {
-            auto tess = tessNewTess(nullptr);
+            auto tess = s_tesselator.get();
             if( !tess ) return false;
             
             auto end_pos = contour_indices[i];
@@ -184,7 +222,7 @@ namespace openswf
             
             if( !tessTesselate(tess, TESS_WINDING_NONZERO, TESS_POLYGONS, MAX_POLYGON_SIZE, 2, 0) )
             {
-                tessDeleteTess(tess);
+                s_tesselator.reset();
                 return false;
             }
 
@@ -218,7 +256,6 @@ namespace openswf
                 }
             }
 
-            tessDeleteTess(tess);
             out_indices_size.push_back( out_indices.size() );
             out_vertices_size.push_back( out_vertices.size() );
         }
@@ -236,7 +273,7 @@ namespace openswf
         if( shape && shape->initialize(cid, std::move(fill_styles), std::move(line_styles), std::move(record)) )
             return shape;
 
-        LWARNING("failed to initialize shape!");
+        LWARNING(LOG_PARSER, "failed to initialize shape!\n");
         if( shape ) delete shape;
         return nullptr;
     }
@@ -251,14 +288,22 @@ namespace openswf
         this->fill_styles   = std::move(fill_styles);
         this->line_styles   = std::move(line_styles);
 
-        return tesselate(
+        ProfileScope scope(LOAD_PHASE_TESSELLATE);
+        if( !tesselate(
             record->vertices, record->contour_indices, this->fill_styles,
-            this->vertices, this->vertices_size, this->indices, this->indices_size);
+            this->vertices, this->vertices_size, this->indices, this->indices_size) )
+            return false;
+
+        ProfileScope::count_allocation(
+            this->vertices.capacity()*sizeof(VertexPack) +
+            this->indices.capacity()*sizeof(uint16_t) +
+            (this->vertices_size.capacity()+this->indices_size.capacity())*sizeof(uint16_t));
+        return true;
     }
 
     INode* Shape::create_instance()
     {
-        return new ShapeNode(this->m_player, this);
+        return m_player->get_node_pool().create<ShapeNode>(m_player, this);
     }
 
     void Shape::set_player(Player* env)
@@ -266,7 +311,7 @@ namespace openswf
         ICharacter::set_player(env);
 
         for( auto& style : fill_styles )
-            style->attach(env);
+            style->attach(env, character_id);
     }
 
     uint16_t Shape::get_character_id() const
@@ -339,7 +384,7 @@ namespace openswf
     {
         ICharacter::set_player(env);
         for( auto& style : fill_styles )
-            style->attach(env);
+            style->attach(env, character_id);
     }
 
     uint16_t MorphShape::get_character_id() const
@@ -349,7 +394,7 @@ namespace openswf
 
     INode* MorphShape::create_instance()
     {
-        return new MorphShapeNode(this->m_player, this);
+        return m_player->get_node_pool().create<MorphShapeNode>(m_player, this);
     }
 
     void MorphShape::tesselate(uint16_t ratio, 
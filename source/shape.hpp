@@ -5,6 +5,7 @@
 
 namespace openswf
 {
+    struct CharacterCost;
     class ShapeFill;
     typedef std::unique_ptr<ShapeFill> ShapeFillPtr;
 
@@ -13,6 +14,8 @@ namespace openswf
     protected:
         uint16_t        m_texture_cid;
         BitmapPtr   m_bitmap;
+        Image*      m_image;
+        CharacterCost*  m_cost;     // of the shape, with LOAD_PROFILE
 
         Rid         m_texture_rid;
         Rect        m_coordinate;
@@ -32,8 +35,9 @@ namespace openswf
         static ShapeFillPtr create(uint16_t cid, const Matrix&);
         static ShapeFillPtr create(uint16_t cid, const Matrix&, const Matrix&);
 
-        void    attach(Player* env);
-        Rid     get_bitmap() const;
+        void    attach(Player* env, uint16_t cid);
+        // the texture is created on the first use, on the render thread.
+        Rid     get_bitmap();
         Color   get_additive_color(uint16_t ratio = 0) const;
         Point2f get_texcoord(const Point2f&, uint16_t ratio = 0) const;
     };
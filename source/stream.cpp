@@ -71,44 +71,30 @@ uint32_t Stream::read_encoded_uint32()
     return value;
 }
 
-uint32_t Stream::read_bits_as_uint32(const int bitcount)
+void Stream::refill_bits()
 {
-    assert(bitcount<=32 && bitcount>=0);
-
-    uint32_t value = 0;
-    uint16_t bits_needed = bitcount;
-    while( bits_needed > 0 ) {
-        if( m_unused_bits > 0 ) {
-            if( bits_needed >= m_unused_bits ) {
-                // consume all the unused bits
-                value |= (m_current_byte << (bits_needed - m_unused_bits));
-                bits_needed -= m_unused_bits;
-
-                m_current_byte = 0;
-                m_unused_bits = 0;
-            } else {
-                // consume some of the unused bits
-                value |= (m_current_byte >> (m_unused_bits - bits_needed));
-
-                // mask off the bits we consumed
-                m_current_byte &= ((1 << (m_unused_bits - bits_needed)) -1);
-
-                m_unused_bits -= bits_needed;
-                // printf("COMSUME LEFT %02x(%d)\n", m_current_byte, m_unused_bits);
-
-                // we're done
-                bits_needed = 0;
-            }
-        } else {
-            // printf("COMSUME %d: %02x\n", m_offset, m_data[m_offset]);
-            m_current_byte = m_data[m_offset++];
-            m_unused_bits = 8;
-        }
+    if( m_offset + 8 <= m_size )
+    {
+        // loads a whole big-endian word, and only keeps the bytes fit in cache.
+        // the rest bits are masked, bytes beyond them might be not inflated yet.
+        uint64_t word = 0;
+        for( auto i=0; i<8; i++ )
+            word = (word << 8) | m_data[m_offset+i];
+
+        auto bytes = (63 - m_unused_bits) >> 3;
+        m_bit_cache |= word >> m_unused_bits;
+        m_offset += bytes;
+        m_unused_bits += bytes << 3;
+        m_bit_cache &= ~(~(uint64_t)0 >> m_unused_bits);
+        return;
     }
 
-    // printf("GET %02x\n", value);
-    assert( bits_needed == 0 );
-    return value;
+    // tail of stream, one byte at a time
+    while( m_unused_bits <= 56 && m_offset < m_size )
+    {
+        m_bit_cache |= (uint64_t)m_data[m_offset++] << (56 - m_unused_bits);
+        m_unused_bits += 8;
+    }
 }
 
 Matrix Stream::read_matrix()
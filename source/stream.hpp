@@ -15,15 +15,18 @@ namespace openswf
         uint32_t        m_offset;
         uint32_t        m_size;
 
-        uint8_t         m_current_byte;
+        // bit values are buffered msb-first in a 64-bit cache, and m_unused_bits
+        // of them are not consumed yet. m_offset always points to the first byte
+        // which is not cached, the cached whole bytes are given back when aligned.
+        uint64_t        m_bit_cache;
         uint32_t        m_unused_bits;
 
     public:
         Stream()
-        : m_data(nullptr), m_offset(0), m_size(0), m_current_byte(0), m_unused_bits(0) {}
+        : m_data(nullptr), m_offset(0), m_size(0), m_bit_cache(0), m_unused_bits(0) {}
 
         Stream(const uint8_t* raw, int size) 
-        : m_data(raw), m_offset(0), m_size(size), m_current_byte(0), m_unused_bits(0) {}
+        : m_data(raw), m_offset(0), m_size(size), m_bit_cache(0), m_unused_bits(0) {}
 
         ~Stream() {}
 
@@ -117,6 +120,13 @@ namespace openswf
 
         BytesPtr        extract(uint32_t size) const;
         void            record(uint8_t* dst, uint32_t size) const;
+
+    protected:
+        // refills the bit cache with whole bytes, up to 64 bits.
+        void            refill_bits();
+        // consumes bitcount bits, returns the cache before consuming,
+        // so the bits are aligned to the most significant bit.
+        uint64_t        consume_bits(const int bitcount);
     };
 
     inline uint8_t Stream::read_uint8() 
@@ -171,11 +181,31 @@ namespace openswf
         return value;
     }
 
+    inline uint64_t Stream::consume_bits(const int bitcount)
+    {
+        if( m_unused_bits < (uint32_t)bitcount )
+            refill_bits();
+
+        assert( m_unused_bits >= (uint32_t)bitcount );
+        auto bits = m_bit_cache;
+        m_bit_cache <<= bitcount;
+        m_unused_bits -= bitcount;
+        return bits;
+    }
+
+    inline uint32_t Stream::read_bits_as_uint32(const int bitcount)
+    {
+        assert( bitcount<=32 && bitcount>=0 );
+        if( bitcount == 0 ) return 0;
+        return (uint32_t)(consume_bits(bitcount) >> (64-bitcount));
+    }
+
     inline int32_t Stream::read_bits_as_int32(const int bitcount)
     {
-        int32_t value = (int32_t)read_bits_as_uint32(bitcount);
-        if( value & (1<<(bitcount-1)) ) value |= ((~0) << bitcount);
-        return value;
+        assert( bitcount<=32 && bitcount>=0 );
+        if( bitcount == 0 ) return 0;
+        // arithmetic shift copies the high bit to the leftmost bits
+        return (int32_t)((int64_t)consume_bits(bitcount) >> (64-bitcount));
     }
 
     inline float Stream::read_bits_as_fixed16(const int bitcount)
@@ -235,15 +265,14 @@ namespace openswf
 
     inline void Stream::align() 
     { 
-        m_unused_bits = m_current_byte = 0; 
+        m_offset -= m_unused_bits >> 3;
+        m_unused_bits = 0;
+        m_bit_cache = 0;
     }
 
     inline const uint8_t* Stream::get_current_ptr() const
     {
-        if( m_unused_bits > 0 )
-            return m_data + m_offset + 1;
-        else
-            return m_data + m_offset;
+        return m_data + get_position();
     }
 
     inline uint32_t Stream::get_bit_position() const
@@ -251,9 +280,10 @@ namespace openswf
         return m_offset*8 - m_unused_bits;
     }
 
+    // the position of the byte right after the partially consumed one.
     inline uint32_t Stream::get_position() const
     {
-        return m_offset;
+        return m_offset - (m_unused_bits >> 3);
     }
 
     inline uint32_t Stream::get_size() const
@@ -265,22 +295,23 @@ namespace openswf
     {
         m_offset = pos;
         m_unused_bits = 0;
+        m_bit_cache = 0;
     }
 
     inline bool Stream::is_finished() const
     {
-        return m_offset >= m_size && m_unused_bits <= 0;
+        return get_bit_position() >= m_size*8;
     }
 
     inline BytesPtr Stream::extract(uint32_t size) const
     {
         auto bytes = new (std::nothrow) uint8_t[size];
-        memcpy(bytes, m_data+m_offset, size);
+        memcpy(bytes, get_current_ptr(), size);
         return BytesPtr(bytes);
     }
 
     inline void Stream::record(uint8_t* dst, uint32_t size) const
     {
-        memcpy(dst, m_data+m_offset, size);
+        memcpy(dst, get_current_ptr(), size);
     }
 }
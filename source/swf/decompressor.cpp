@@ -0,0 +1,237 @@
+#include "swf/decompressor.hpp"
+
+extern "C" {
+    #include "zlib.h"
+    #include "lzma.h"
+}
+
+namespace openswf
+{
+    const static uint32_t HeaderSize        = 8;
+    const static uint32_t DecompressChunk   = 64 * 1024;
+
+    /// ZLIB, CWS
+    class ZlibDecompressor : public Decompressor
+    {
+    protected:
+        z_stream    m_strm;
+        bool        m_initialized;
+
+    public:
+        ZlibDecompressor() : m_initialized(false) {}
+
+        virtual ~ZlibDecompressor()
+        {
+            if( m_initialized ) inflateEnd(&m_strm);
+        }
+
+    protected:
+        virtual bool initialize()
+        {
+            m_strm.zalloc   = Z_NULL;
+            m_strm.zfree    = Z_NULL;
+            m_strm.opaque   = Z_NULL;
+            m_strm.next_in  = Z_NULL;
+            m_strm.avail_in = 0;
+
+            if( Z_OK != inflateInit(&m_strm) )
+            {
+                LERROR(LOG_LOADER, "inflateInit failed!\n");
+                return false;
+            }
+
+            m_initialized = true;
+            return true;
+        }
+
+        virtual bool inflate(uint32_t size)
+        {
+            m_strm.next_in      = (uint8_t*)m_source + m_consumed;
+            m_strm.avail_in     = m_source_size - m_consumed;
+            m_strm.next_out     = m_buffer.get() + m_available;
+            m_strm.avail_out    = size;
+
+            auto result = ::inflate(&m_strm, Z_NO_FLUSH);
+            m_consumed = m_strm.next_in - m_source;
+            m_available += size - m_strm.avail_out;
+
+            if( result == Z_STREAM_END )
+                m_finished = true;
+            // Z_BUF_ERROR means no progress, the source is not enough
+            return result == Z_OK || result == Z_STREAM_END || result == Z_BUF_ERROR;
+        }
+    };
+
+    /// LZMA, ZWS
+    // the lzma header of swf differs from the one used by lzma_alone:
+    // UI32 compressed length, 5 bytes of properties, and no uncompressed size.
+    const static uint32_t LzmaHeaderSize    = 4 + 5;
+    const static uint32_t LzmaAloneSize     = 5 + 8;
+
+    class LzmaDecompressor : public Decompressor
+    {
+    protected:
+        lzma_stream m_strm;
+        bool        m_initialized;
+        bool        m_header_ready;
+        bool        m_header_consumed;
+        uint8_t     m_header[LzmaAloneSize];
+
+    public:
+        LzmaDecompressor()
+        : m_strm(LZMA_STREAM_INIT), m_initialized(false),
+        m_header_ready(false), m_header_consumed(false) {}
+
+        virtual ~LzmaDecompressor()
+        {
+            if( m_initialized ) lzma_end(&m_strm);
+        }
+
+    protected:
+        virtual bool initialize()
+        {
+            if( LZMA_OK != lzma_alone_decoder(&m_strm, UINT64_MAX) )
+            {
+                LERROR(LOG_LOADER, "lzma_alone_decoder failed!\n");
+                return false;
+            }
+
+            m_initialized = true;
+            return true;
+        }
+
+        virtual bool inflate(uint32_t size)
+        {
+            if( !m_header_ready )
+            {
+                // waits for the properties
+                if( m_source_size < LzmaHeaderSize )
+                    return true;
+
+                // a synthesized lzma_alone header: properties + uncompressed size,
+                // which is fed to lzma before the compressed data.
+                uint64_t body_size = m_size - HeaderSize;
+                memcpy(m_header, m_source + 4, 5);
+                for( auto i=0; i<8; i++ )
+                    m_header[5+i] = (uint8_t)(body_size >> (i*8));
+
+                m_header_ready  = true;
+                m_consumed      = LzmaHeaderSize;
+                m_strm.next_in  = m_header;
+                m_strm.avail_in = LzmaAloneSize;
+            }
+
+            m_strm.next_out     = m_buffer.get() + m_available;
+            m_strm.avail_out    = size;
+
+            auto result = LZMA_OK;
+            if( !m_header_consumed )
+            {
+                result = lzma_code(&m_strm, LZMA_RUN);
+                m_header_consumed = (result == LZMA_OK && m_strm.avail_in == 0);
+            }
+
+            if( m_header_consumed )
+            {
+                m_strm.next_in  = m_source + m_consumed;
+                m_strm.avail_in = m_source_size - m_consumed;
+                result = lzma_code(&m_strm, LZMA_RUN);
+                m_consumed = m_strm.next_in - m_source;
+            }
+            m_available += size - m_strm.avail_out;
+
+            if( result == LZMA_STREAM_END )
+                m_finished = true;
+            // LZMA_BUF_ERROR means no progress, the source is not enough
+            return result == LZMA_OK || result == LZMA_STREAM_END || result == LZMA_BUF_ERROR;
+        }
+    };
+
+    /// DECOMPRESSOR
+    DecompressorPtr Decompressor::create(Stream& stream)
+    {
+        auto start      = stream.get_position();
+        auto signature  = (char)stream.read_uint8();
+        auto const_w    = (char)stream.read_uint8();
+        auto const_s    = (char)stream.read_uint8();
+        auto version    = stream.read_uint8();
+        auto size       = stream.read_uint32();
+
+        assert( const_w == 'W' && const_s == 'S' );
+
+        Decompressor* decompressor = nullptr;
+        if( signature == 'C' )
+            decompressor = new (std::nothrow) ZlibDecompressor();
+        else if( signature == 'Z' )
+            decompressor = new (std::nothrow) LzmaDecompressor();
+
+        if( decompressor == nullptr || size < HeaderSize )
+        {
+            if( decompressor ) delete decompressor;
+            stream.set_position(start);
+            return nullptr;
+        }
+
+        decompressor->m_buffer = BytesPtr(new (std::nothrow) uint8_t[size]);
+        if( decompressor->m_buffer == nullptr )
+        {
+            delete decompressor;
+            stream.set_position(start);
+            return nullptr;
+        }
+
+        // the inflated bytes are exactly a uncompressed swf file
+        auto buffer = decompressor->m_buffer.get();
+        buffer[0] = 'F'; buffer[1] = 'W'; buffer[2] = 'S'; buffer[3] = version;
+        for( auto i=0; i<4; i++ )
+            buffer[4+i] = (uint8_t)(size >> (i*8));
+
+        decompressor->m_size        = size;
+        decompressor->m_available   = HeaderSize;
+        decompressor->m_source      = stream.get_current_ptr();
+        decompressor->m_source_size = stream.get_size() - stream.get_position();
+        decompressor->m_stream      = Stream(buffer, size);
+
+        stream.set_position(start);
+        if( !decompressor->initialize() )
+        {
+            delete decompressor;
+            return nullptr;
+        }
+
+        return DecompressorPtr(decompressor);
+    }
+
+    bool Decompressor::advance(uint32_t position)
+    {
+        position = std::min(position, m_size);
+        while( m_available < position && !m_finished )
+        {
+            // always inflate whole chunks to keep calls into zlib/lzma rare
+            auto chunk = std::min(m_size - m_available,
+                std::max(position - m_available, DecompressChunk));
+
+            auto available = m_available;
+            auto consumed = m_consumed;
+            if( !inflate(chunk) )
+            {
+                LERROR(LOG_LOADER, "failed to decompress swf stream.\n");
+                m_finished = true;
+                break;
+            }
+
+            // waits for more compressed bytes
+            if( available == m_available && consumed == m_consumed )
+                break;
+        }
+
+        return m_available >= position;
+    }
+
+    void Decompressor::set_source(const uint8_t* bytes, uint32_t size)
+    {
+        assert( size >= HeaderSize && size - HeaderSize >= m_source_size );
+        m_source        = bytes + HeaderSize;
+        m_source_size   = size - HeaderSize;
+    }
+}
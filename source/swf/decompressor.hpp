@@ -0,0 +1,82 @@
+#pragma once
+
+#include "stream.hpp"
+
+#include <memory>
+
+namespace openswf
+{
+    class Decompressor;
+    typedef std::unique_ptr<Decompressor> DecompressorPtr;
+
+    // a compressed swf file keeps the first 8 bytes of its header (signature,
+    // version and the uncompressed file length) as plain bytes, everything after
+    // that is compressed with ZLIB (CWS, swf 6 and later) or LZMA (ZWS, swf 13 and later).
+    // the decompressor inflates the body on demand into a buffer sized by the
+    // uncompressed file length, so tags could be consumed as soon as their bytes
+    // are inflated, and the inflated bytes are never copied once more.
+    class Decompressor
+    {
+    protected:
+        BytesPtr        m_buffer;
+        uint32_t        m_size;
+        uint32_t        m_available;
+        bool            m_finished;
+
+        const uint8_t*  m_source;
+        uint32_t        m_source_size;
+        uint32_t        m_consumed;
+        Stream          m_stream;
+
+    public:
+        // returns nullptr if the stream is not compressed,
+        // the source bytes must be valid during the life of decompressor.
+        static DecompressorPtr create(Stream& stream);
+        virtual ~Decompressor() {}
+
+        // makes sure the bytes in range [0, position) have been inflated,
+        // returns false if the compressed bytes received are not enough.
+        bool        advance(uint32_t position);
+
+        // the compressed file received so far, including the leading 8 bytes.
+        // its used when loading progressively, the bytes might be moved.
+        void        set_source(const uint8_t* bytes, uint32_t size);
+
+        // the inflated stream, its header are rewritten to a uncompressed 'FWS' one.
+        Stream&     get_stream();
+        uint32_t    get_available() const;
+        uint32_t    get_size() const;
+        // returns true if the compressed stream has ended, or failed to inflate.
+        bool        is_finished() const;
+
+    protected:
+        Decompressor()
+        : m_size(0), m_available(0), m_finished(false),
+        m_source(nullptr), m_source_size(0), m_consumed(0) {}
+
+        virtual bool initialize() = 0;
+        // inflates at most size bytes to the end of available buffer from
+        // the unconsumed source, returns false if the data is corrupted.
+        virtual bool inflate(uint32_t size) = 0;
+    };
+
+    inline Stream& Decompressor::get_stream()
+    {
+        return m_stream;
+    }
+
+    inline uint32_t Decompressor::get_available() const
+    {
+        return m_available;
+    }
+
+    inline uint32_t Decompressor::get_size() const
+    {
+        return m_size;
+    }
+
+    inline bool Decompressor::is_finished() const
+    {
+        return m_finished;
+    }
+}
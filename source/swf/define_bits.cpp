@@ -19,6 +19,7 @@ namespace openswf
 
     static void decompress(const uint8_t* source, int src_size, uint8_t* dst, int dst_size)
     {
+        ProfileScope scope(LOAD_PHASE_INFLATE);
         z_stream strm;
 
         /* allocate inflate state */
@@ -30,7 +31,7 @@ namespace openswf
 
         if( Z_OK != inflateInit(&strm) )
         {
-            printf("deflateInit failed!\n");
+            LERROR(LOG_PARSER, "inflateInit failed!\n");
             return;
         }
 
@@ -45,8 +46,11 @@ namespace openswf
         inflateEnd(&strm);
     }
 
-    static BitmapPtr create_jpeg(const uint8_t* source, int jpeg_size, int alpha_size)
+    // the alpha channel is left to be filled if with_alpha.
+    static BitmapPtr decode_jpeg(const uint8_t* source, int jpeg_size, bool with_alpha)
     {
+        ProfileScope scope(LOAD_PHASE_JPEG_DECODE);
+
         struct jpeg_decompress_struct jds;
         struct jpeg_error_mgr jem;
         JSAMPARRAY buffer;
@@ -64,7 +68,7 @@ namespace openswf
 
         buffer = (*jds.mem->alloc_sarray)((j_common_ptr)&jds, JPOOL_IMAGE, width*depth, 1);
         
-        if( alpha_size <= 0 )
+        if( !with_alpha )
         {
             auto bitmap = BitmapRGB8::create(width, height);
             uint8_t* iterator = bitmap->get_ptr();
@@ -92,18 +96,30 @@ namespace openswf
             }
         }
 
+        jpeg_finish_decompress(&jds);
+        jpeg_destroy_decompress(&jds);
+        return std::move(bitmap);
+    }
+
+    static BitmapPtr create_jpeg(const uint8_t* source, int jpeg_size, int alpha_size)
+    {
+        auto bitmap = decode_jpeg(source, jpeg_size, alpha_size > 0);
+        if( alpha_size <= 0 )
+            return bitmap;
+
+        auto width  = bitmap->get_width();
+        auto height = bitmap->get_height();
+
         auto bytes = new uint8_t[width*height];
+        ProfileScope::count_allocation(width*height);
         decompress(source+jpeg_size, alpha_size, bytes, width*height);
 
-        for( int i=0; i<height; i++ )
-            for( int j=0; j<width; j++ )
-                bitmap->get(i, j).a = bytes[i*width+j];
+        auto pixels = bitmap->get_ptr();
+        for( uint32_t i=0; i<width*height; i++ )
+            pixels[i*4+3] = bytes[i];
 
         delete[] bytes;
-
-        jpeg_finish_decompress(&jds);
-        jpeg_destroy_decompress(&jds);
-        return std::move(bitmap);
+        return bitmap;
     }
 
     static Image* create_image(Stream& stream, TagHeader& header, uint16_t cid, uint32_t size)
@@ -159,18 +175,22 @@ namespace openswf
     {
         auto cid = env.stream.read_uint16();
         auto size = env.tag.end_pos - env.stream.get_position();
-        auto image = create_image(env.stream, env.tag, cid, size);
-        if( image != nullptr )
-            env.player.set_character(image->get_character_id(), image);
+        auto tag = env.tag;
+        define_character(env, cid, [=](Stream& stream) mutable
+        {
+            return create_image(stream, tag, cid, size);
+        });
     }
 
     void Parser::DefineBitsJPEG3(Environment& env)
     {
         auto cid = env.stream.read_uint16();
         auto size = env.stream.read_uint32();
-        auto image = create_image(env.stream, env.tag, cid, size);
-        if( image != nullptr )
-            env.player.set_character(image->get_character_id(), image);
+        auto tag = env.tag;
+        define_character(env, cid, [=](Stream& stream) mutable
+        {
+            return create_image(stream, tag, cid, size);
+        });
     }
 
     static Image* create_bits_lossless(Stream& stream, TagHeader& header)
@@ -186,6 +206,7 @@ namespace openswf
             auto src_size = header.end_pos - stream.get_position();
             auto dst_size = table_size*3+width*height; // color table + indices
             auto bytes = BytesPtr(new (std::nothrow) uint8_t[dst_size]);
+            ProfileScope::count_allocation(dst_size);
             decompress(stream.get_current_ptr(), src_size, bytes.get(), dst_size);
 
             auto bitmap = BitmapRGB8::create(width, height);
@@ -224,9 +245,12 @@ namespace openswf
 
     void Parser::DefineBitsLossless(Environment& env)
     {
-        auto image = create_bits_lossless(env.stream, env.tag);
-        if( image != nullptr )
-            env.player.set_character(image->get_character_id(), image);
+        auto cid = peek_character_id(env.stream);
+        auto tag = env.tag;
+        define_character(env, cid, [=](Stream& stream) mutable
+        {
+            return create_bits_lossless(stream, tag);
+        });
     }
 
     static Image* create_bits_lossless2(Stream& stream, TagHeader& header)
@@ -242,6 +266,7 @@ namespace openswf
             auto src_size = header.end_pos - stream.get_position();
             auto dst_size = table_size*4+width*height; // color table + indices
             auto bytes = BytesPtr(new (std::nothrow) uint8_t[dst_size]);
+            ProfileScope::count_allocation(dst_size);
             decompress(stream.get_current_ptr(), src_size, bytes.get(), dst_size);
 
             auto bitmap = BitmapRGBA8::create(width, height);
@@ -272,8 +297,11 @@ namespace openswf
 
     void Parser::DefineBitsLossless2(Environment& env)
     {
-        auto image = create_bits_lossless2(env.stream, env.tag);
-        if( image != nullptr )
-            env.player.set_character(image->get_character_id(), image);
+        auto cid = peek_character_id(env.stream);
+        auto tag = env.tag;
+        define_character(env, cid, [=](Stream& stream) mutable
+        {
+            return create_bits_lossless2(stream, tag);
+        });
     }
 }
\ No newline at end of file
@@ -616,6 +616,7 @@ namespace openswf
     static ShapeRecordPtr create_shape_record(const ShapePathList& paths, const Rect& bounds,
         ShapeFillList& fill_styles, ShapeLineList& line_styles, TagCode type)
     {
+        ProfileScope scope(LOAD_PHASE_CONTOURS);
         auto mesh_set = std::vector<Contours>(fill_styles.size(), Contours());
 
         for( auto& path : paths )
@@ -667,6 +668,9 @@ namespace openswf
 
         assert( contour_indices.size() == fill_styles.size() );
 
+        ProfileScope::count_allocation(
+            vertices.capacity()*sizeof(Point2f) + contour_indices.capacity()*sizeof(uint16_t));
+
         return ShapeRecord::create(bounds, std::move(vertices), std::move(contour_indices));
     }
 
@@ -687,11 +691,15 @@ namespace openswf
 
         ShapeFillList   fill_styles;
         ShapeLineList   line_styles;
+        ShapePathList   paths;
 
-        read_fill_styles(stream, fill_styles, type);
-        read_line_styles(stream, line_styles, type);
+        {
+            ProfileScope scope(LOAD_PHASE_PARSE_BITS);
+            read_fill_styles(stream, fill_styles, type);
+            read_line_styles(stream, line_styles, type);
+            paths = read_shape_path(stream, fill_styles, line_styles, type);
+        }
 
-        auto paths = read_shape_path(stream, fill_styles, line_styles, type);
         auto record = create_shape_record(paths, bounds, fill_styles, line_styles, type);
         return Shape::create(character_id,
              std::move(fill_styles), std::move(line_styles), std::move(record));
@@ -699,30 +707,38 @@ namespace openswf
 
     void Parser::DefineShape(Environment& env)
     {
-        auto shape = create_shape(env.stream, env.tag.code);
-        if( shape != nullptr )
-            env.player.set_character(shape->get_character_id(), shape);
+        auto code = env.tag.code;
+        define_character(env, peek_character_id(env.stream), [=](Stream& stream)
+        {
+            return create_shape(stream, code);
+        });
     }
 
     void Parser::DefineShape2(Environment& env)
     {
-        auto shape = create_shape(env.stream, env.tag.code);
-        if( shape != nullptr )
-            env.player.set_character(shape->get_character_id(), shape);
+        auto code = env.tag.code;
+        define_character(env, peek_character_id(env.stream), [=](Stream& stream)
+        {
+            return create_shape(stream, code);
+        });
     }
 
     void Parser::DefineShape3(Environment& env)
     {
-        auto shape = create_shape(env.stream, env.tag.code);
-        if( shape != nullptr )
-            env.player.set_character(shape->get_character_id(), shape);
+        auto code = env.tag.code;
+        define_character(env, peek_character_id(env.stream), [=](Stream& stream)
+        {
+            return create_shape(stream, code);
+        });
     }
 
     void Parser::DefineShape4(Environment& env)
     {
-        auto shape = create_shape(env.stream, env.tag.code);
-        if( shape != nullptr )
-            env.player.set_character(shape->get_character_id(), shape);
+        auto code = env.tag.code;
+        define_character(env, peek_character_id(env.stream), [=](Stream& stream)
+        {
+            return create_shape(stream, code);
+        });
     }
 
     static MorphShape* create_morph_shape(Stream& stream, TagCode type)
@@ -744,16 +760,23 @@ namespace openswf
 
         ShapeFillList   fill_styles;
         ShapeLineList   line_styles;
+        ShapePathList   start_paths, end_paths;
 
-        read_fill_styles(stream, fill_styles, type);
-        read_line_styles(stream, line_styles, type);
+        {
+            ProfileScope scope(LOAD_PHASE_PARSE_BITS);
+            read_fill_styles(stream, fill_styles, type);
+            read_line_styles(stream, line_styles, type);
+            start_paths = read_shape_path(stream, fill_styles, line_styles, type);
+        }
 
-        auto start_paths = read_shape_path(stream, fill_styles, line_styles, type);
         auto start_record = create_shape_record(start_paths, start_bounds, fill_styles, line_styles, type);
 
         assert(stream.get_position() == offset);
         stream.set_position(offset); // clean unused bits
-        auto end_paths = read_shape_path(stream, fill_styles, line_styles, type);
+        {
+            ProfileScope scope(LOAD_PHASE_PARSE_BITS);
+            end_paths = read_shape_path(stream, fill_styles, line_styles, type);
+        }
 
         assert( start_paths.size() == end_paths.size() );
         for( auto i=0; i<start_paths.size(); i++ )
@@ -773,15 +796,19 @@ namespace openswf
 
     void Parser::DefineMorphShape(Environment& env)
     {
-        auto shape = create_morph_shape(env.stream, env.tag.code);
-        if( shape != nullptr )
-            env.player.set_character(shape->get_character_id(), shape);
+        auto code = env.tag.code;
+        define_character(env, peek_character_id(env.stream), [=](Stream& stream)
+        {
+            return create_morph_shape(stream, code);
+        });
     }
 
     void Parser::DefineMorphShape2(Environment& env)
     {
-        auto shape = create_morph_shape(env.stream, env.tag.code);
-        if( shape != nullptr )
-            env.player.set_character(shape->get_character_id(), shape);
+        auto code = env.tag.code;
+        define_character(env, peek_character_id(env.stream), [=](Stream& stream)
+        {
+            return create_morph_shape(stream, code);
+        });
     }
 }
\ No newline at end of file
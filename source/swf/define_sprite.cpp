@@ -12,51 +12,125 @@ namespace openswf
         auto frame_count = env.stream.read_uint16();
 
         env.interrupted = std::move(env.frame);
+        env.frame = MovieFrame();
         env.movie = new MovieClip(cid, frame_count, env.header.frame_rate);
     }
 
     void Parser::End(Environment& env)
     {
         assert(env.movie != nullptr);
+        env.movie->m_loaded = true;
+
+        // the End tag of root movie indicates the end of file
+        if( env.movie == &env.player.get_root_def() )
+        {
+            env.finished = true;
+            return;
+        }
+
         env.player.set_character(env.movie->get_character_id(), env.movie);
 
         env.movie = &env.player.get_root_def();
         env.frame = std::move(env.interrupted);
     }
 
+    void Parser::add_command(Environment& env, const FrameCommand& command)
+    {
+        auto movie = env.movie;
+        if( env.frame.command_count == 0 )
+            env.frame.command_start = movie->m_commands.size();
+
+        movie->m_commands.push_back(command);
+        env.frame.command_count ++;
+    }
+
+    void Parser::read_place_object(Environment& env, uint8_t mask, uint16_t depth)
+    {
+        auto& stream = env.stream;
+        auto command = FrameCommand(FrameCommandType::PLACE, depth);
+        command.mask = mask;
+
+        if( mask & PLACE_2_HAS_CHARACTER )
+            command.character_id = stream.read_uint16();
+
+        if( mask & PLACE_2_HAS_MATRIX )
+            command.matrix = stream.read_matrix().to_pixel(false);
+
+        if( mask & PLACE_2_HAS_CXFORM )
+            command.cxform = stream.read_cxform_rgba();
+
+        if( mask & PLACE_2_HAS_RATIO )
+            command.ratio = stream.read_uint16();
+
+        if( mask & PLACE_2_HAS_NAME )
+        {
+            command.name = env.movie->m_names.size();
+            env.movie->m_names.push_back(env.player.get_atoms().intern(stream.read_string()));
+        }
+
+        if( mask & PLACE_2_HAS_CLIP_DEPTH )
+            command.clip_depth = stream.read_uint16();
+
+        add_command(env, command);
+    }
+
     void Parser::PlaceObject(Environment& env)
     {
-        env.frame.commands.push_back(FrameCommand::create(
-            env.tag,
-            env.stream.extract(env.tag.size)));
+        auto& stream = env.stream;
+        auto character_id = stream.read_uint16();
+        auto depth = stream.read_uint16();
+
+        auto command = FrameCommand(FrameCommandType::PLACE, depth);
+        command.mask = PLACE_2_HAS_CHARACTER | PLACE_2_HAS_MATRIX;
+        command.character_id = character_id;
+        command.matrix = stream.read_matrix().to_pixel(false);
+
+        if( stream.get_position() < env.tag.end_pos )
+        {
+            command.mask |= PLACE_2_HAS_CXFORM;
+            command.cxform = stream.read_cxform_rgb();
+        }
+
+        add_command(env, command);
     }
 
     void Parser::PlaceObject2(Environment& env)
     {
-        env.frame.commands.push_back(FrameCommand::create(
-            env.tag,
-            env.stream.extract(env.tag.size)));
+        auto mask = env.stream.read_uint8();
+        auto depth = env.stream.read_uint16();
+        read_place_object(env, mask, depth);
+
+        // skip clip actions
     }
 
     void Parser::PlaceObject3(Environment& env)
     {
-        env.frame.commands.push_back(FrameCommand::create(
-            env.tag,
-            env.stream.extract(env.tag.size)));
+        auto mask2 = env.stream.read_uint8();
+        /*auto mask3 = */env.stream.read_uint8();
+        auto depth = env.stream.read_uint16();
+
+//        std::string name;
+//        if( (mask3 & PLACE_3_HAS_CLASS_NAME) ||
+//            ((mask3 & PLACE_3_HAS_IMAGE) && (mask2 & PLACE_2_HAS_CHARACTER)) )
+//        {
+//            name = stream.read_string();
+//        }
+
+        read_place_object(env, mask2, depth);
+
+        // skip surface filters, bitmap cache, visible,
+        // background color, clip actions
     }
 
     void Parser::RemoveObject(Environment& env)
     {
-        env.frame.commands.push_back(FrameCommand::create(
-            env.tag,
-            env.stream.extract(env.tag.size)));
+        env.stream.read_uint16();
+        add_command(env, FrameCommand(FrameCommandType::REMOVE, env.stream.read_uint16()));
     }
 
     void Parser::RemoveObject2(Environment& env)
     {
-        env.frame.commands.push_back(FrameCommand::create(
-            env.tag,
-            env.stream.extract(env.tag.size)));
+        add_command(env, FrameCommand(FrameCommandType::REMOVE, env.stream.read_uint16()));
     }
 
     void Parser::FrameLabel(Environment& env)
@@ -73,13 +147,16 @@ namespace openswf
 
     void Parser::DoAction(Environment& env)
     {
-        env.frame.actions.push_back(FrameAction::create(
-            env.tag,
-            env.stream.extract(env.tag.size)));
+        auto action = FrameAction::create(env.tag, env.stream.get_current_ptr(),
+            env.player.get_atoms(), env.header.version, env.movie->get_character_id(),
+            env.movie->m_frames.size());
+        if( action != nullptr )
+            env.frame.actions.push_back(std::move(action));
     }
 
     void Parser::ShowFrame(Environment& env)
     {
         env.movie->m_frames.push_back(std::move(env.frame));
+        env.frame = MovieFrame();
     }
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "parser.hpp"
 #include "stream.hpp"
+#include "avm/virtual_machine.hpp"
 
 namespace openswf
 {
@@ -32,5 +33,9 @@ namespace openswf
     {
         env.player.m_script_max_recursion = env.stream.read_uint16();
         env.player.m_script_timeout = env.stream.read_uint16();
+
+        if( env.player.m_avm != nullptr )
+            env.player.m_avm->set_script_limits(
+                env.player.m_script_max_recursion, env.player.m_script_timeout);
     }
 }
\ No newline at end of file
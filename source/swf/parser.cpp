@@ -1,13 +1,15 @@
 #include "swf/parser.hpp"
+#include "swf/tag_index.hpp"
 #include "movie_clip.hpp"
 #include "stream.hpp"
+#include "thread_pool.hpp"
 
 #include <unordered_map>
 
 namespace openswf
 {
     Environment::Environment(Stream& stream, Player& player, const SWFHeader& header)
-    : stream(stream), player(player), header(header)
+    : stream(stream), player(player), header(header), finished(false), options(0)
     {
         this->movie         = &player.get_root_def();
         this->tag.code      = TagCode::END;
@@ -16,12 +18,58 @@ namespace openswf
 
     bool Environment::advance()
     {
-        if( this->tag.code != TagCode::DEFINE_SPRITE )
-            this->stream.set_position(this->tag.end_pos);
-        this->tag = TagHeader::read(this->stream);
-
-        if( this->tag.code == TagCode::END && this->movie == &this->player.get_root_def() )
+        if( this->finished )
             return false;
+
+        // nested tags of a sprite follow its header
+        auto position = this->tag.code == TagCode::DEFINE_SPRITE ?
+            this->stream.get_position() : this->tag.end_pos;
+
+        // a tag header takes 2 bytes, or 6 bytes if its long, and the whole tag should
+        // be received before handling it, including all the nested tags of a sprite.
+        auto size = this->stream.get_size();
+        if( position >= size )
+            return end_of_file(size);
+
+        if( position+2 > size )
+            return end_of_file(position);
+
+        if( !this->player.is_available(position+2) )
+            return this->player.is_source_ended() && end_of_file(position);
+
+        this->stream.set_position(position);
+        auto length = (this->stream.read_uint16() & 0x3f) == 0x3f ? 6 : 2;
+        this->stream.set_position(position);
+        if( position+length > size )
+            return end_of_file(position);
+
+        if( !this->player.is_available(position+length) )
+            return this->player.is_source_ended() && end_of_file(position);
+
+        auto tag = TagHeader::read(this->stream);
+        this->stream.set_position(position);
+        if( tag.end_pos > size || tag.end_pos < position+length )
+            return end_of_file(position);
+
+        if( !this->player.is_available(tag.end_pos) )
+            return this->player.is_source_ended() && end_of_file(position);
+
+        // headers are indexed as they arrive, before the tag is handled
+        this->stream.set_position(position + length);
+        this->player.m_tag_index->add(this->stream, tag);
+        this->tag = tag;
+        return true;
+    }
+
+    bool Environment::end_of_file(uint32_t position)
+    {
+        // a truncated file is ended as if there is an End tag
+        if( position < this->stream.get_size() )
+            LWARNING(LOG_LOADER, "swf file is truncated at %u bytes.\n", position);
+
+        this->tag.code      = TagCode::END;
+        this->tag.size      = 0;
+        this->tag.end_pos   = position;
         return true;
     }
 
@@ -103,7 +151,8 @@ namespace openswf
         record.version      = stream.read_uint8();
         record.size         = stream.read_uint32();
 
-        assert( !record.compressed ); // compressed mode not supports
+        // compressed files should be inflated by Decompressor first
+        assert( !record.compressed );
         assert( (char)const_w == 'W' && (char)const_s == 'S' );
 
         record.frame_size    = stream.read_rect();
@@ -116,8 +165,40 @@ namespace openswf
         return record;
     }
 
+    uint32_t SWFHeader::get_length(uint8_t rect_byte)
+    {
+        // signature, version, file length, rect, frame rate and frame count
+        auto bits = 5 + 4 * (rect_byte >> 3);
+        return 8 + (bits + 7) / 8 + 4;
+    }
+
     bool Parser::execute(Environment& env)
     {
+        auto profiler = env.player.m_profiler.get();
+        if( profiler == nullptr )
+            return dispatch(env);
+
+        auto start_pos = env.stream.get_position();
+        auto start = LoadProfiler::now();
+        auto handled = dispatch(env);
+
+        // a stub consumes the character id only, and nested tags of a sprite
+        // are counted by themselves.
+        auto deferred = (env.options & LOAD_LAZY_CHARACTERS) && is_deferrable(env.tag.code);
+        auto consumed = deferred || env.tag.code == TagCode::DEFINE_SPRITE ?
+            env.stream.get_position() - start_pos : env.tag.size;
+        profiler->add_tag(env.tag, consumed, LoadProfiler::now() - start);
+        return handled;
+    }
+
+    bool Parser::dispatch(Environment& env)
+    {
+        if( (env.options & LOAD_LAZY_CHARACTERS) && is_deferrable(env.tag.code) )
+        {
+            Defer(env);
+            return true;
+        }
+
         auto found = s_handlers.find((uint32_t)env.tag.code);
         if( found == s_handlers.end() ) return false;
 
@@ -125,6 +206,82 @@ namespace openswf
         return true;
     }
 
+    bool Parser::is_deferrable(TagCode code)
+    {
+        switch(code)
+        {
+        case TagCode::DEFINE_SHAPE:
+        case TagCode::DEFINE_SHAPE2:
+        case TagCode::DEFINE_SHAPE3:
+        case TagCode::DEFINE_SHAPE4:
+        case TagCode::DEFINE_MORPH_SHAPE:
+        case TagCode::DEFINE_MORPH_SHAPE2:
+        case TagCode::DEFINE_BITS_JPEG2:
+        case TagCode::DEFINE_BITS_JPEG3:
+        case TagCode::DEFINE_BITS_LOSSLESS:
+        case TagCode::DEFINE_BITS_LOSSLESS2:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void Parser::Defer(Environment& env)
+    {
+        // the byte range of definition is looked up from the tag index
+        auto cid = env.stream.read_uint16();
+        auto stub = new (std::nothrow) LazyCharacter(cid);
+        if( stub == nullptr )
+            return;
+
+        env.player.set_character(cid, stub);
+        env.player.m_lazy_characters ++;
+    }
+
+    void Parser::define_character(Environment& env, uint16_t cid,
+        std::function<ICharacter*(Stream&)> decode)
+    {
+        auto profiler = env.player.m_profiler.get();
+        auto record = profiler ? profiler->add_character(cid, env.tag) : nullptr;
+
+        if( env.options & LOAD_PARALLEL )
+        {
+            auto stream = env.stream;
+            env.player.defer_character(cid, ThreadPool::get_instance().submit(
+                [=]() mutable
+                {
+                    ProfileScope scope(record);
+                    return decode(stream);
+                }));
+            return;
+        }
+
+        // the scope is closed before publishing, attaching might decode others
+        ICharacter* ch = nullptr;
+        {
+            ProfileScope scope(record);
+            ch = decode(env.stream);
+        }
+
+        if( ch != nullptr )
+            env.player.set_character(cid, ch);
+    }
+
+    uint16_t Parser::peek_character_id(Stream& stream)
+    {
+        auto position = stream.get_position();
+        auto cid = stream.read_uint16();
+        stream.set_position(position);
+        return cid;
+    }
+
+    INode* LazyCharacter::create_instance()
+    {
+        // the stub is deleted once resolved, do not touch members after
+        auto ch = m_player->get_character(m_character_id);
+        return ch != nullptr ? ch->create_instance() : nullptr;
+    }
+
     const char* Parser::to_string(TagCode code)
     {
         switch(code)
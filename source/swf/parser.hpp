@@ -3,6 +3,8 @@
 #include "player.hpp"
 #include "movie_clip.hpp"
 
+#include <functional>
+
 namespace openswf
 {
     // forward declarations
@@ -22,9 +24,31 @@ namespace openswf
         TagHeader       tag;
 
         SWFHeader       header;
+        bool            finished;
+        uint32_t        options;    // LoadOptionMask
 
         Environment(Stream& stream, Player& player, const SWFHeader& header);
+        // returns false if the next tag has not been received completely,
+        // or the End tag of root movie has been handled.
         bool advance();
+        // synthesizes an End tag at position, where the bytes of file end.
+        bool end_of_file(uint32_t position);
+    };
+
+    // a stub of character definition which keeps the character id only, its
+    // decoded by Player::get_character on the first use, from the defining
+    // tag found in the tag index.
+    class LazyCharacter : public ICharacter
+    {
+    protected:
+        uint16_t    m_character_id;
+
+    public:
+        LazyCharacter(uint16_t cid)
+        : m_character_id(cid) {}
+
+        virtual INode*   create_instance();
+        virtual uint16_t get_character_id() const;
     };
 
     class Parser
@@ -34,7 +58,26 @@ namespace openswf
         static bool         execute(Environment& env);
         static const char*  to_string(TagCode);
 
+        // returns true if the definition could be decoded lazily.
+        static bool         is_deferrable(TagCode);
+
     protected:
+        static bool dispatch(Environment&);
+        static void Defer(Environment&);
+
+        // decodes the definition on worker threads with LOAD_PARALLEL, or
+        // immediately. the stream passed to decode is a copy at current position.
+        // its cost is recorded as a character with LOAD_PROFILE.
+        static void define_character(Environment&, uint16_t cid,
+            std::function<ICharacter*(Stream&)> decode);
+        // the character id which the definition tag starts with.
+        static uint16_t peek_character_id(Stream&);
+
+        // appends a decoded display list command to the current frame.
+        static void add_command(Environment&, const FrameCommand&);
+        // decodes the fields of PlaceObject2/3 following the depth.
+        static void read_place_object(Environment&, uint8_t mask, uint16_t depth);
+
         /// ----------------------------------------------------------------------------
         /// GENERIC CONTROL TAGS
         static void SetBackgroundColor(Environment&);
@@ -162,4 +205,10 @@ namespace openswf
         // (alpha values).
         static void DefineBitsLossless2(Environment&);
     };
+
+    /// INLINE METHODS
+    inline uint16_t LazyCharacter::get_character_id() const
+    {
+        return m_character_id;
+    }
 }
\ No newline at end of file
@@ -101,6 +101,9 @@ namespace openswf
         uint16_t    frame_count;  // total number of frames in file
 
         static SWFHeader read(Stream& stream);
+        // the header length varies with the bit count of frame size, which is
+        // given by the first byte following the leading 8 bytes.
+        static uint32_t get_length(uint8_t rect_byte);
     };
 
     struct TagHeader
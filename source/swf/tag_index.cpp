@@ -0,0 +1,153 @@
+#include "swf/tag_index.hpp"
+
+namespace openswf
+{
+    TagIndexPtr TagIndex::create(Stream& stream)
+    {
+        auto index = new (std::nothrow) TagIndex();
+        if( index && index->initialize(stream) )
+            return TagIndexPtr(index);
+
+        if( index ) delete index;
+        return nullptr;
+    }
+
+    TagIndexPtr TagIndex::create()
+    {
+        return TagIndexPtr(new (std::nothrow) TagIndex());
+    }
+
+    TagIndex::TagIndex()
+    {
+        m_movies.push_back(0);
+        m_frames[0].push_back(0);
+    }
+
+    bool TagIndex::initialize(Stream& stream)
+    {
+        stream.set_position(0);
+        SWFHeader::read(stream);
+
+        auto size = stream.get_size();
+        while( stream.get_position() < size )
+        {
+            auto tag = TagHeader::read(stream);
+            if( tag.end_pos > size )
+            {
+                LWARNING(LOG_LOADER, "tag %d at %d is truncated.\n", (int)tag.code, stream.get_position());
+                break;
+            }
+
+            if( !add(stream, tag) )
+                break;
+
+            // scans into the nested tags of sprite
+            if( tag.code == TagCode::DEFINE_SPRITE && tag.size >= 4 )
+                stream.set_position(stream.get_position() + 4);
+            else
+                stream.set_position(tag.end_pos);
+        }
+
+        return true;
+    }
+
+    bool TagIndex::add(Stream& stream, const TagHeader& tag)
+    {
+        if( m_movies.empty() )
+            return false;
+
+        auto position = stream.get_position();
+        auto index = (uint32_t)m_tags.size();
+        m_tags.push_back({ tag.code, position, tag.size });
+
+        // all definition tags start with the character id
+        uint16_t cid = 0;
+        if( is_definition(tag.code) && tag.size >= 2 )
+        {
+            cid = stream.read_uint16();
+            stream.set_position(position);
+            m_characters[cid] = index;
+        }
+
+        if( tag.code == TagCode::DEFINE_SPRITE && tag.size >= 4 )
+        {
+            m_movies.push_back(cid);
+            m_frames[cid].clear();
+            m_frames[cid].push_back(index+1);
+            return true;
+        }
+
+        if( tag.code == TagCode::SHOW_FRAME )
+            m_frames[m_movies.back()].push_back(index+1);
+
+        if( tag.code == TagCode::END )
+            m_movies.pop_back();
+
+        return !m_movies.empty();
+    }
+
+    int32_t TagIndex::find_character(uint16_t cid) const
+    {
+        auto found = m_characters.find(cid);
+        if( found == m_characters.end() ) return -1;
+        return (int32_t)found->second;
+    }
+
+    bool TagIndex::has_movie(uint16_t movie) const
+    {
+        return m_frames.find(movie) != m_frames.end();
+    }
+
+    uint16_t TagIndex::get_frame_count(uint16_t movie) const
+    {
+        auto found = m_frames.find(movie);
+        if( found == m_frames.end() ) return 0;
+        return (uint16_t)(found->second.size() - 1);
+    }
+
+    bool TagIndex::get_frame(uint16_t movie, uint16_t frame, uint32_t& first, uint32_t& last) const
+    {
+        auto found = m_frames.find(movie);
+        if( found == m_frames.end() || frame < 1 || frame >= found->second.size() )
+            return false;
+
+        first   = found->second[frame-1];
+        last    = found->second[frame];
+        return true;
+    }
+
+    bool TagIndex::is_definition(TagCode code)
+    {
+        switch(code)
+        {
+        case TagCode::DEFINE_SHAPE:
+        case TagCode::DEFINE_SHAPE2:
+        case TagCode::DEFINE_SHAPE3:
+        case TagCode::DEFINE_SHAPE4:
+        case TagCode::DEFINE_MORPH_SHAPE:
+        case TagCode::DEFINE_MORPH_SHAPE2:
+        case TagCode::DEFINE_BITS:
+        case TagCode::DEFINE_BITS_JPEG2:
+        case TagCode::DEFINE_BITS_JPEG3:
+        case TagCode::DEFINE_BITS_JPEG4:
+        case TagCode::DEFINE_BITS_LOSSLESS:
+        case TagCode::DEFINE_BITS_LOSSLESS2:
+        case TagCode::DEFINE_BUTTON:
+        case TagCode::DEFINE_BUTTON2:
+        case TagCode::DEFINE_TEXT:
+        case TagCode::DEFINE_TEXT2:
+        case TagCode::DEFINE_EDIT_TEXT:
+        case TagCode::DEFINE_FONT:
+        case TagCode::DEFINE_FONT2:
+        case TagCode::DEFINE_FONT3:
+        case TagCode::DEFINE_FONT4:
+        case TagCode::DEFINE_SOUND:
+        case TagCode::DEFINE_VIDEO_STREAM:
+        case TagCode::DEFINE_BINARY_DATA:
+        case TagCode::DEFINE_SPRITE:
+            return true;
+        default:
+            return false;
+        }
+    }
+}
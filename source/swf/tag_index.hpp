@@ -0,0 +1,85 @@
+#pragma once
+
+#include "stream.hpp"
+#include "swf/record.hpp"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace openswf
+{
+    struct IndexedTag
+    {
+        TagCode     code;
+        uint32_t    offset; // offset in bytes of tag body from the beginning of file
+        uint32_t    size;   // size in bytes of tag body
+    };
+
+    class TagIndex;
+    typedef std::unique_ptr<TagIndex> TagIndexPtr;
+
+    // a index of all tags in a uncompressed swf file, which is built by
+    // scanning tag headers only. tags are indexed in the order of file, so
+    // nested tags of a sprite follow its DefineSprite tag immediately, and
+    // they are also a part of the frame of root movie containing the sprite.
+    // its built by a pass over a complete file, or tag by tag while loading.
+    class TagIndex
+    {
+        typedef std::unordered_map<uint16_t, uint32_t> Characters;
+        typedef std::unordered_map<uint16_t, std::vector<uint32_t>> Frames;
+
+    protected:
+        std::vector<IndexedTag> m_tags;
+        Characters              m_characters;   // character id -> tag index
+        Frames                  m_frames;       // movie id -> the first tag index of each frame
+        std::vector<uint16_t>   m_movies;       // the movies being scanned, root is the first one
+
+    public:
+        // the stream should be a complete uncompressed swf file.
+        static TagIndexPtr create(Stream& stream);
+        // creates an empty index, which is filled by add().
+        static TagIndexPtr create();
+
+        // appends a tag whose header has just been read, the stream should be
+        // at the beginning of its body, and its position is kept.
+        // returns false once the End tag of root movie has been added.
+        bool                add(Stream& stream, const TagHeader& tag);
+
+        uint32_t            get_tag_count() const;
+        const IndexedTag&   get_tag(uint32_t index) const;
+
+        // returns the index of tag defining the character, or -1 if not found.
+        int32_t             find_character(uint16_t cid) const;
+        const IndexedTag*   get_character(uint16_t cid) const;
+
+        // the movie id of root is 0, others are character ids of sprites.
+        bool                has_movie(uint16_t movie) const;
+        uint16_t            get_frame_count(uint16_t movie = 0) const;
+        // tags in range [first, last) belong to the frame, which starts from 1.
+        bool                get_frame(uint16_t movie, uint16_t frame, uint32_t& first, uint32_t& last) const;
+
+        static bool         is_definition(TagCode code);
+
+    protected:
+        TagIndex();
+        bool initialize(Stream& stream);
+    };
+
+    inline uint32_t TagIndex::get_tag_count() const
+    {
+        return m_tags.size();
+    }
+
+    inline const IndexedTag& TagIndex::get_tag(uint32_t index) const
+    {
+        assert( index < m_tags.size() );
+        return m_tags[index];
+    }
+
+    inline const IndexedTag* TagIndex::get_character(uint16_t cid) const
+    {
+        auto index = find_character(cid);
+        return index < 0 ? nullptr : &m_tags[index];
+    }
+}
@@ -0,0 +1,51 @@
+#include "thread_pool.hpp"
+
+namespace openswf
+{
+    ThreadPool& ThreadPool::get_instance()
+    {
+        static ThreadPool s_instance(std::max(std::thread::hardware_concurrency(), 1u));
+        return s_instance;
+    }
+
+    ThreadPool::ThreadPool(uint32_t size)
+    : m_stopped(false)
+    {
+        m_workers.reserve(size);
+        for( uint32_t i=0; i<size; i++ )
+            m_workers.emplace_back(&ThreadPool::work, this);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+
+        m_condition.notify_all();
+        for( auto& worker : m_workers )
+            worker.join();
+    }
+
+    void ThreadPool::work()
+    {
+        while( true )
+        {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this]() { return m_stopped || !m_tasks.empty(); });
+
+                // tasks left are finished before stopping
+                if( m_tasks.empty() )
+                    return;
+
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+
+            task();
+        }
+    }
+}
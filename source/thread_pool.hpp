@@ -0,0 +1,64 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openswf
+{
+    // a fixed size pool of worker threads shared by all players, its used to
+    // decode independent definitions while the tag loop keeps going.
+    class ThreadPool
+    {
+        typedef std::function<void()> Task;
+
+    protected:
+        std::vector<std::thread>    m_workers;
+        std::deque<Task>            m_tasks;
+        std::mutex                  m_mutex;
+        std::condition_variable     m_condition;
+        bool                        m_stopped;
+
+    public:
+        // the pool is created on first use, with a worker per hardware thread.
+        static ThreadPool& get_instance();
+        ~ThreadPool();
+
+        template<typename F>
+        std::future<typename std::result_of<F()>::type> submit(F&& f);
+
+        uint32_t get_size() const;
+
+    protected:
+        ThreadPool(uint32_t size);
+        void work();
+    };
+
+    /// INLINE METHODS
+    template<typename F>
+    std::future<typename std::result_of<F()>::type> ThreadPool::submit(F&& f)
+    {
+        typedef typename std::result_of<F()>::type R;
+
+        // std::function requires a copyable target
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        auto future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back([task]() { (*task)(); });
+        }
+
+        m_condition.notify_one();
+        return future;
+    }
+
+    inline uint32_t ThreadPool::get_size() const
+    {
+        return m_workers.size();
+    }
+}
@@ -2,3 +2,10 @@
 
 #include "catch.hpp"
 #include "openswf_common.hpp"
+
+// the handlers of parser are registered once, by the first test case using it
+inline bool initialize_parser()
+{
+    static bool s_initialized = openswf::Parser::initialize();
+    return s_initialized;
+}
@@ -0,0 +1,55 @@
+#include "openswf_test.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("LOGGER", "[OPENSWF]")
+{
+    auto& logger = openswf::Logger::get_instance();
+
+    std::vector<std::string> messages;
+    logger.set_sink([&](openswf::LogLevel level, openswf::LogCategory category, const char* message)
+    {
+        messages.push_back(message);
+    });
+
+    SECTION( "runtime filters of categories" )
+    {
+        openswf::Logger::set_level(openswf::LOG_AVM, openswf::LOG_LEVEL_ERROR);
+        LINFO(openswf::LOG_AVM, "filtered %d\n", 1);
+        LINFO(openswf::LOG_LOADER, "buffered %d\n", 2);
+        REQUIRE( messages.size() == 0 );
+
+        // warnings are written out immediately, with the buffered ones
+        LWARNING(openswf::LOG_LOADER, "warning %s\n", "3");
+        REQUIRE( messages.size() == 2 );
+        REQUIRE( messages[0] == "buffered 2\n" );
+        REQUIRE( messages[1] == "warning 3\n" );
+    }
+
+    SECTION( "writes from multiple threads" )
+    {
+        auto dropped = logger.get_dropped();
+
+        std::vector<std::thread> threads;
+        for( auto i=0; i<4; i++ )
+        {
+            threads.emplace_back([i]()
+            {
+                for( auto j=0; j<100; j++ )
+                    LINFO(openswf::LOG_GENERIC, "%d-%d\n", i, j);
+            });
+        }
+
+        for( auto& thread : threads )
+            thread.join();
+
+        logger.flush();
+        INFO( messages.size() << " " << logger.get_dropped() - dropped );
+        REQUIRE( messages.size() + logger.get_dropped() - dropped == 400 );
+    }
+
+    openswf::Logger::set_level(openswf::LOG_LEVEL_INFO);
+    logger.set_sink(nullptr);
+}
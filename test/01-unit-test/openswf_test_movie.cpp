@@ -1,11 +1,12 @@
 #include "openswf_test.hpp"
+#include "avm/context_object.hpp"
 #include <random>
 
 using namespace openswf;
 
 TEST_CASE( "TIMELINE", "[OPENSWF]" )
 {
-    REQUIRE( Parser::initialize() );
+    REQUIRE( initialize_parser() );
 
     std::random_device random;
     auto stream = create_from_file("../test/resources/simple-timeline-1.swf");
@@ -48,3 +49,696 @@ TEST_CASE( "TIMELINE", "[OPENSWF]" )
     REQUIRE( movie.get_current_frame() == 1 );
 }
 
+
+TEST_CASE( "FRAME_COMMANDS", "[OPENSWF]" )
+{
+    REQUIRE( initialize_parser() );
+
+    auto player = Player::create_from_file("../test/resources/simple-timeline-1.swf");
+    REQUIRE( player != nullptr );
+
+    auto stream = create_from_file("../test/resources/simple-timeline-1.swf");
+    auto index = player->get_tag_index();
+    auto& movie = player->get_root_def();
+
+    // the records are decoded in the order of tags
+    auto total = 0;
+    for( auto frame=1; frame<=movie.get_frames_loaded(); frame++ )
+    {
+        uint32_t first, last, count;
+        REQUIRE( index->get_frame(0, frame, first, last) );
+
+        auto command = movie.get_frame_commands(frame-1, count);
+        auto decoded = 0;
+        for( auto i=first; i<last; i++ )
+        {
+            auto& tag = index->get_tag(i);
+            stream.set_position(tag.offset);
+
+            if( tag.code == TagCode::PLACE_OBJECT2 )
+            {
+                auto mask = stream.read_uint8();
+                auto depth = stream.read_uint16();
+
+                REQUIRE( decoded < count );
+                REQUIRE( command[decoded].type == FrameCommandType::PLACE );
+                REQUIRE( command[decoded].mask == mask );
+                REQUIRE( command[decoded].depth == depth );
+                if( mask & PLACE_2_HAS_CHARACTER )
+                    REQUIRE( command[decoded].character_id == stream.read_uint16() );
+                decoded ++;
+            }
+            else if( tag.code == TagCode::REMOVE_OBJECT2 )
+            {
+                REQUIRE( decoded < count );
+                REQUIRE( command[decoded].type == FrameCommandType::REMOVE );
+                REQUIRE( command[decoded].depth == stream.read_uint16() );
+                decoded ++;
+            }
+        }
+
+        REQUIRE( decoded == count );
+        total += count;
+    }
+
+    REQUIRE( total > 0 );
+
+    // looping the timeline applies the same records once more
+    uint32_t count;
+    auto depth = movie.get_frame_commands(0, count)->depth;
+    REQUIRE( count > 0 );
+
+    auto& root = player->get_root();
+    root.update(0);
+    auto node = root.get(depth);
+    REQUIRE( node != nullptr );
+    auto position = node->get_position();
+
+    root.goto_frame(3, MovieGoto::PLAY);
+    root.update(0);
+    root.goto_frame(1, MovieGoto::PLAY);
+    root.update(0);
+
+    node = root.get(depth);
+    REQUIRE( node != nullptr );
+    REQUIRE( node->get_position().x == Approx(position.x) );
+    REQUIRE( node->get_position().y == Approx(position.y) );
+
+    delete player;
+}
+
+TEST_CASE( "KEYFRAME_SNAPSHOTS", "[OPENSWF]" )
+{
+    REQUIRE( initialize_parser() );
+
+    auto expected = Player::create_from_file("../test/resources/simple-timeline-1.swf");
+    auto player = Player::create_from_file("../test/resources/simple-timeline-1.swf");
+    REQUIRE( expected != nullptr );
+    REQUIRE( player != nullptr );
+
+    expected->get_root_def().set_keyframe_interval(0);
+    REQUIRE( expected->get_root_def().get_keyframe(2) == nullptr );
+
+    auto& movie = player->get_root_def();
+    movie.set_keyframe_interval(1);
+
+    auto keyframe = movie.get_keyframe(2);
+    REQUIRE( keyframe != nullptr );
+    REQUIRE( keyframe->frame == 2 );
+    REQUIRE( movie.get_keyframe(0)->placements.size() == 0 );
+    for( size_t i=1; i<keyframe->placements.size(); i++ )
+        REQUIRE( keyframe->placements[i-1].depth < keyframe->placements[i].depth );
+
+    // seeks backward from the last frame restore the same display list
+    // as replaying from the first frame.
+    for( auto target=1; target<=3; target++ )
+    {
+        for( auto p : { expected, player } )
+        {
+            p->get_root().goto_frame(3, MovieGoto::STOP);
+            p->get_root().update(0);
+            p->get_root().goto_frame(target, MovieGoto::STOP);
+            p->get_root().update(0);
+            REQUIRE( p->get_root().get_current_frame() == target );
+        }
+
+        for( uint16_t depth=0; depth<64; depth++ )
+        {
+            auto node = player->get_root().get(depth);
+            auto compare = expected->get_root().get(depth);
+            REQUIRE( (node == nullptr) == (compare == nullptr) );
+            if( node == nullptr ) continue;
+
+            REQUIRE( node->get_character_id() == compare->get_character_id() );
+            REQUIRE( node->get_position().x == Approx(compare->get_position().x) );
+            REQUIRE( node->get_position().y == Approx(compare->get_position().y) );
+            REQUIRE( node->get_scale().x == Approx(compare->get_scale().x) );
+        }
+    }
+
+    delete player;
+    delete expected;
+}
+
+// a movie of empty frames, each one runs "n = n + 1"
+static std::vector<uint8_t> create_counter_movie(uint16_t frames)
+{
+    const uint8_t action[] = {
+        0x96, 0x06, 0x00, 0x00, 'n', 0x00, 0x00, 'n', 0x00,
+        0x1C,
+        0x96, 0x05, 0x00, 0x01, 0x00, 0x00, 0x80, 0x3F,
+        0x0A,
+        0x1D,
+        0x00 };
+
+    std::vector<uint8_t> bytes = {
+        'F', 'W', 'S', 10, 0, 0, 0, 0,
+        0x00,                                       // empty frame size
+        0x00, 0x18,                                 // 24 fps
+        (uint8_t)frames, (uint8_t)(frames >> 8) };
+
+    for( auto i=0; i<frames; i++ )
+    {
+        bytes.push_back((uint8_t)((12 << 6) | sizeof(action)));  // DoAction
+        bytes.push_back((12 << 6) >> 8);
+        bytes.insert(bytes.end(), action, action + sizeof(action));
+        bytes.push_back(1 << 6);                    // ShowFrame
+        bytes.push_back(0);
+    }
+
+    bytes.push_back(0);                             // End
+    bytes.push_back(0);
+
+    auto size = (uint32_t)bytes.size();
+    for( auto i=0; i<4; i++ )
+        bytes[4+i] = (uint8_t)(size >> (i*8));
+    return bytes;
+}
+
+TEST_CASE( "KEYFRAME_ACTIONS", "[OPENSWF]" )
+{
+    REQUIRE( initialize_parser() );
+
+    auto bytes = create_counter_movie(40);
+    auto stream = Stream(bytes.data(), bytes.size());
+
+    // the same scripts run whatever the snapshot interval is
+    for( auto interval : { 0, 1, 16 } )
+    {
+        auto player = Player::create(stream);
+        REQUIRE( player != nullptr );
+        REQUIRE( player->get_root().get_frame_count() == 40 );
+        player->get_root_def().set_keyframe_interval(interval);
+
+        auto n = player->get_atoms().intern("n");
+        auto context = player->get_root().get_context();
+        context->set_variable(n, avm::Value().set_integer(0));
+
+        // frames advanced over run their actions, the ones replayed backward
+        // run the target frame only
+        auto& movie = player->get_root();
+        auto start = movie.get_current_frame();
+        movie.goto_frame(35, MovieGoto::STOP);
+        movie.update(0);
+        REQUIRE( context->get_variable(n).to_number() == Approx(35 - start) );
+
+        movie.goto_frame(20, MovieGoto::STOP);
+        movie.update(0);
+        REQUIRE( context->get_variable(n).to_number() == Approx(36 - start) );
+
+        movie.goto_frame(21, MovieGoto::STOP);
+        movie.update(0);
+        REQUIRE( context->get_variable(n).to_number() == Approx(37 - start) );
+        delete player;
+    }
+}
+
+TEST_CASE( "FRAME_CATCH_UP", "[OPENSWF]" )
+{
+    REQUIRE( initialize_parser() );
+
+    auto bytes = create_counter_movie(40);
+    auto stream = Stream(bytes.data(), bytes.size());
+    auto player = Player::create(stream);
+    REQUIRE( player != nullptr );
+
+    auto& movie = player->get_root();
+    movie.set_frame_rate(1.0f);
+    movie.update(0);
+
+    auto n = player->get_atoms().intern("n");
+    auto context = movie.get_context();
+    context->set_variable(n, avm::Value().set_integer(0));
+
+    // a late update advances several frames at once, and runs all of them
+    auto start = movie.get_current_frame();
+    movie.update(5.5f);
+    REQUIRE( movie.get_current_frame() == start + 5 );
+    REQUIRE( context->get_variable(n).to_number() == Approx(5) );
+
+    movie.update(3.0f);
+    REQUIRE( movie.get_current_frame() == start + 8 );
+    REQUIRE( context->get_variable(n).to_number() == Approx(8) );
+    delete player;
+}
+
+TEST_CASE( "DISPLAY_LIST", "[OPENSWF]" )
+{
+    DisplayList list;
+    auto node = [](uintptr_t value) { return (INode*)value; };
+
+    list[3] = node(3);
+    list[7] = node(7);
+    list[1] = node(1);
+    list[5] = node(5);
+    list[7] = node(8);
+    REQUIRE( list.size() == 4 );
+
+    uint16_t depths[] = { 1, 3, 5, 7 };
+    auto i = 0;
+    for( auto& pair : list )
+        REQUIRE( pair.first == depths[i++] );
+
+    REQUIRE( list.find(7)->second == node(8) );
+    REQUIRE( list.find(4) == list.end() );
+    REQUIRE( list.find(9) == list.end() );
+
+    list.erase(list.find(3));
+    REQUIRE( list.size() == 3 );
+    REQUIRE( list.find(3) == list.end() );
+    REQUIRE( list.find(5)->second == node(5) );
+
+    list.clear();
+    REQUIRE( list.empty() );
+    REQUIRE( list.find(1) == list.end() );
+}
+
+TEST_CASE( "NODE_POOL", "[OPENSWF]" )
+{
+    REQUIRE( initialize_parser() );
+
+    auto player = Player::create_from_file("../test/resources/simple-timeline-1.swf");
+    REQUIRE( player != nullptr );
+
+    auto& pool = player->get_node_pool();
+    auto& root = player->get_root();
+    root.set_frame_rate(1.0f);
+
+    // warms up the pool with the first loop of timeline
+    for( auto i=0; i<root.get_frame_count()*2; i++ )
+        player->update(1.01f);
+
+    auto slabs = pool.get_slab_count();
+    REQUIRE( slabs > 0 );
+
+    // looping the timeline takes no more blocks
+    for( auto i=0; i<root.get_frame_count()*10; i++ )
+    {
+        player->update(1.01f);
+        root.goto_frame(1);
+        player->update(0);
+    }
+
+    REQUIRE( pool.get_slab_count() == slabs );
+
+    // a recycled node is reset before its reused
+    uint32_t count;
+    auto depth = player->get_root_def().get_frame_commands(0, count)->depth;
+    auto node = root.get(depth);
+    REQUIRE( node != nullptr );
+
+    auto cid = node->get_character_id();
+    auto recycled = pool.get_recycled_count();
+    node->set_name("recycled");
+    root.erase(depth);
+    REQUIRE( pool.get_recycled_count() == recycled+1 );
+
+    auto reused = root.set(depth, cid);
+    REQUIRE( reused == node );
+    REQUIRE( reused->get_name().empty() );
+    REQUIRE( pool.get_recycled_count() == recycled );
+
+    delete player;
+}
+
+TEST_CASE( "NODE_PATH", "[OPENSWF]" )
+{
+    REQUIRE( initialize_parser() );
+
+    uint8_t buffer[] = {
+        'F', 'W', 'S', 10, 64, 0, 0, 0,         // signature, version, file length
+        0x00, 0x00, 0x18, 0x01, 0x00,           // frame size, frame rate, frame count
+        0xc8, 0x09, 0x07, 0x00, 0x01, 0x00,     // DefineSprite, id: 7, frame count: 1
+        0x40, 0x00, 0x00, 0x00,                 // ShowFrame, End
+        0xd1, 0x09, 0x08, 0x00, 0x01, 0x00,     // DefineSprite, id: 8, frame count: 1
+        0x87, 0x06, 0x22, 0x01, 0x00,           // PlaceObject2, depth: 1
+        0x07, 0x00, 'b', 0x00,                  // character: 7, name: b
+        0x40, 0x00, 0x00, 0x00,                 // ShowFrame, End
+        0x87, 0x06, 0x22, 0x01, 0x00,           // PlaceObject2, depth: 1
+        0x08, 0x00, 'a', 0x00,                  // character: 8, name: a
+        0x87, 0x06, 0x22, 0x02, 0x00,           // PlaceObject2, depth: 2
+        0x07, 0x00, 'c', 0x00,                  // character: 7, name: c
+        0x40, 0x00, 0x00, 0x00                  // ShowFrame, End
+    };
+
+    auto stream = Stream(buffer, sizeof(buffer));
+    auto player = Player::create(stream);
+    REQUIRE( player != nullptr );
+    player->update(0);
+
+    auto& atoms = player->get_atoms();
+    REQUIRE( atoms.intern("a") == atoms.intern(std::string("a")) );
+    REQUIRE( atoms.find("x", 1).empty() );
+    REQUIRE( atoms.intern("").empty() );
+
+    auto& root = player->get_root();
+    auto a = root.get("a");
+    REQUIRE( a != nullptr );
+    REQUIRE( a->get_name() == "a" );
+    REQUIRE( a->get_parent() == &root );
+
+    auto b = root.get("a/b");
+    REQUIRE( b != nullptr );
+    REQUIRE( b == a->get("b") );
+    REQUIRE( b == root.get("/a/b") );
+    REQUIRE( b == root.get(NodePath::create(atoms, "a/b")) );
+    REQUIRE( root.get("b") == nullptr );
+    REQUIRE( root.get("a/") == nullptr );
+    REQUIRE( root.get("x/b") == nullptr );
+    REQUIRE( !NodePath::create(atoms, "a//").is_valid() );
+
+    // the index follows renaming and removing
+    auto c = root.get<MovieNode>("c");
+    REQUIRE( c != nullptr );
+    c->set_name("d");
+    REQUIRE( root.get("c") == nullptr );
+    REQUIRE( root.get("d") == c );
+
+    root.erase(2);
+    REQUIRE( root.get("d") == nullptr );
+
+    delete player;
+}
+
+TEST_CASE( "COMPRESSED_MOVIE", "[OPENSWF]" )
+{
+    REQUIRE( initialize_parser() );
+
+    auto stream = create_from_file("../test/resources/simple-timeline-1.swf");
+    auto expected = Player::create(stream);
+
+    const char* files[] = {
+        "../test/resources/simple-timeline-1-zlib.swf",
+        "../test/resources/simple-timeline-1-lzma.swf" };
+
+    for( auto path : files )
+    {
+        auto compressed = create_from_file(path);
+        auto player = Player::create(compressed);
+        REQUIRE( player != nullptr );
+
+        REQUIRE( player->get_version() == expected->get_version() );
+        REQUIRE( player->get_size().get_width() == Approx(expected->get_size().get_width()) );
+        REQUIRE( player->get_root().get_frame_count() == expected->get_root().get_frame_count() );
+
+        player->update(0);
+        REQUIRE( player->get_root().get_current_frame() == 1 );
+        delete player;
+    }
+
+    delete expected;
+}
+
+TEST_CASE( "PLAYER_FROM_FILE", "[OPENSWF]" )
+{
+    REQUIRE( initialize_parser() );
+
+    auto stream = create_from_file("../test/resources/simple-timeline-1.swf");
+    auto expected = Player::create(stream);
+
+    const char* files[] = {
+        "../test/resources/simple-timeline-1.swf",
+        "../test/resources/simple-timeline-1-zlib.swf",
+        "../test/resources/simple-timeline-1-lzma.swf" };
+
+    for( auto path : files )
+    {
+        // the mapped file is the same movie as a copied stream
+        auto player = Player::create_from_file(path);
+        REQUIRE( player != nullptr );
+        REQUIRE( player->is_loaded() );
+        REQUIRE( player->get_version() == expected->get_version() );
+        REQUIRE( player->get_frames_loaded() == expected->get_frames_loaded() );
+        REQUIRE( player->get_root().get_frame_count() == expected->get_root().get_frame_count() );
+
+        player->update(0);
+        REQUIRE( player->get_root().get_current_frame() == 1 );
+        delete player;
+    }
+
+    REQUIRE( Player::create_from_file("../test/resources/missing.swf") == nullptr );
+    delete expected;
+}
+
+TEST_CASE( "PROGRESSIVE_LOADING", "[OPENSWF]" )
+{
+    REQUIRE( initialize_parser() );
+
+    const char* files[] = {
+        "../test/resources/simple-timeline-1.swf",
+        "../test/resources/simple-timeline-1-zlib.swf",
+        "../test/resources/simple-timeline-1-lzma.swf" };
+
+    for( auto path : files )
+    {
+        auto source = FileSource::create(path);
+        REQUIRE( source != nullptr );
+
+        auto player = Player::create();
+        REQUIRE( player != nullptr );
+        REQUIRE( player->get_frames_loaded() == 0 );
+        REQUIRE( !player->is_loaded() );
+
+        uint16_t frames_loaded = 0;
+        for( uint32_t offset = 0; offset < source->get_size(); offset += 7 )
+        {
+            auto size = std::min((uint32_t)7, source->get_size() - offset);
+            REQUIRE( player->load(source->get_data() + offset, size) );
+            REQUIRE( player->get_frames_loaded() >= frames_loaded );
+            frames_loaded = player->get_frames_loaded();
+
+            // tags are indexed as they arrive
+            if( player->get_tag_index() != nullptr )
+                REQUIRE( player->get_tag_index()->get_frame_count() == frames_loaded );
+
+            if( frames_loaded > 0 && !player->is_loaded() )
+            {
+                // holds at the last loaded frame
+                auto& movie = player->get_root();
+                movie.set_frame_rate(1.0f);
+                movie.update(1.1f);
+                movie.update(1.1f);
+                REQUIRE( movie.get_current_frame() <= frames_loaded );
+            }
+        }
+
+        REQUIRE( player->is_loaded() );
+        REQUIRE( player->get_frames_loaded() == 3 );
+        REQUIRE( player->get_root().get_frame_count() == 3 );
+        REQUIRE( player->get_tag_index() != nullptr );
+        REQUIRE( player->get_tag_index()->get_frame_count() == 3 );
+        delete player;
+    }
+
+    auto player = Player::create();
+    uint8_t invalid[] = { 'P', 'K', 0x03, 0x04, 0x00, 0x00, 0x00, 0x00 };
+    REQUIRE( !player->load(invalid, sizeof(invalid)) );
+    delete player;
+}
+
+TEST_CASE( "TRUNCATED_MOVIE", "[OPENSWF]" )
+{
+    REQUIRE( initialize_parser() );
+
+    const char* files[] = {
+        "../test/resources/simple-timeline-1.swf",
+        "../test/resources/simple-timeline-1-zlib.swf",
+        "../test/resources/simple-timeline-1-lzma.swf" };
+
+    SECTION( "the end of a complete source is the end of movie" )
+    {
+        for( auto path : files )
+        {
+            auto source = FileSource::create(path);
+            REQUIRE( source != nullptr );
+
+            auto stream = Stream(source->get_data(), 300);
+            auto player = Player::create(stream);
+            REQUIRE( player != nullptr );
+            REQUIRE( player->is_loaded() );
+            REQUIRE( player->get_frames_loaded() < 3 );
+
+            player->update(0);
+            delete player;
+        }
+    }
+
+    SECTION( "more bytes might be received progressively" )
+    {
+        for( auto path : files )
+        {
+            auto source = FileSource::create(path);
+            auto player = Player::create();
+            REQUIRE( player->load(source->get_data(), 300) );
+            REQUIRE( !player->is_loaded() );
+            delete player;
+        }
+    }
+
+    SECTION( "the length in header is not trusted" )
+    {
+        auto source = FileSource::create(files[0]);
+        std::vector<uint8_t> bytes(source->get_data(), source->get_data() + source->get_size());
+        bytes[4] = bytes[5] = bytes[6] = bytes[7] = 0xFF;
+
+        auto player = Player::create();
+        for( uint32_t offset = 0; offset < bytes.size(); offset += 7 )
+        {
+            auto size = std::min((uint32_t)7, (uint32_t)bytes.size() - offset);
+            REQUIRE( player->load(bytes.data() + offset, size) );
+        }
+
+        REQUIRE( player->is_loaded() );
+        REQUIRE( player->get_frames_loaded() == 3 );
+        delete player;
+    }
+}
+
+TEST_CASE( "LAZY_CHARACTERS", "[OPENSWF]" )
+{
+    REQUIRE( initialize_parser() );
+
+    const char* files[] = {
+        "../test/resources/simple-timeline-1.swf",
+        "../test/resources/simple-timeline-1-zlib.swf" };
+
+    for( auto path : files )
+    {
+        auto player = Player::create_from_file(path, LOAD_LAZY_CHARACTERS);
+        REQUIRE( player != nullptr );
+        REQUIRE( player->get_lazy_characters() == 3 );
+
+        // the shape placed by first frame is decoded only
+        player->update(0);
+        REQUIRE( player->get_root().get_current_frame() == 1 );
+        REQUIRE( player->get_lazy_characters() == 2 );
+
+        auto index = player->get_tag_index();
+        auto stream = create_from_file("../test/resources/simple-timeline-1.swf");
+        stream.set_position(index->get_tag(10).offset);
+        auto cid = stream.read_uint16();
+
+        REQUIRE( player->get_character<Shape>(cid) != nullptr );
+        REQUIRE( player->get_lazy_characters() == 1 );
+        REQUIRE( player->get_character<Shape>(cid) == player->get_character<Shape>(cid) );
+        delete player;
+    }
+}
+
+TEST_CASE( "PARALLEL_LOADING", "[OPENSWF]" )
+{
+    REQUIRE( initialize_parser() );
+
+    auto expected = Player::create_from_file("../test/resources/simple-shape-2.swf");
+    auto player = Player::create_from_file("../test/resources/simple-shape-2.swf", LOAD_PARALLEL);
+    REQUIRE( expected != nullptr );
+    REQUIRE( player != nullptr );
+
+    auto index = player->get_tag_index();
+    auto& tag = index->get_tag(4);
+    REQUIRE( tag.code == TagCode::DEFINE_BITS_LOSSLESS2 );
+
+    auto stream = create_from_file("../test/resources/simple-shape-2.swf");
+    stream.set_position(tag.offset);
+    auto cid = stream.read_uint16();
+
+    auto image = player->get_character<Image>(cid);
+    auto compare = expected->get_character<Image>(cid);
+    REQUIRE( image != nullptr );
+    REQUIRE( compare != nullptr );
+    REQUIRE( image->get_player() == player );
+
+    auto& bitmap = image->get_bitmap();
+    REQUIRE( bitmap.get_size() == compare->get_bitmap().get_size() );
+    REQUIRE( memcmp(bitmap.get_ptr(), compare->get_bitmap().get_ptr(), bitmap.get_size()) == 0 );
+
+    // shapes are tesselated by the reused tesselators of workers
+    auto& shape_tag = index->get_tag(5);
+    REQUIRE( shape_tag.code == TagCode::DEFINE_SHAPE4 );
+
+    stream.set_position(shape_tag.offset);
+    cid = stream.read_uint16();
+
+    auto shape = player->get_character<Shape>(cid);
+    auto compare_shape = expected->get_character<Shape>(cid);
+    REQUIRE( shape != nullptr );
+    REQUIRE( compare_shape != nullptr );
+    REQUIRE( shape->vertices.size() == compare_shape->vertices.size() );
+    REQUIRE( shape->vertices.size() > 0 );
+    REQUIRE( shape->vertices_size == compare_shape->vertices_size );
+    REQUIRE( shape->indices == compare_shape->indices );
+    REQUIRE( shape->indices_size == compare_shape->indices_size );
+    REQUIRE( memcmp(shape->vertices.data(), compare_shape->vertices.data(),
+        shape->vertices.size()*sizeof(VertexPack)) == 0 );
+
+    delete player;
+    delete expected;
+}
+
+TEST_CASE( "LOAD_PROFILE", "[OPENSWF]" )
+{
+    REQUIRE( initialize_parser() );
+
+    auto plain = Player::create_from_file("../test/resources/simple-shape-2.swf");
+    REQUIRE( plain != nullptr );
+    REQUIRE( plain->get_load_profiler() == nullptr );
+    REQUIRE( plain->get_load_report().tags.empty() );
+    delete plain;
+
+    const uint32_t options[] = { LOAD_PROFILE, LOAD_PROFILE | LOAD_PARALLEL };
+    for( auto option : options )
+    {
+        auto player = Player::create_from_file("../test/resources/simple-shape-2.swf", option);
+        REQUIRE( player != nullptr );
+
+        auto index = player->get_tag_index();
+        auto report = player->get_load_report();
+        REQUIRE( report.tags.size() > 0 );
+
+        // every tag handled is counted once
+        uint32_t count = 0;
+        for( auto& tag : report.tags )
+            count += tag.count;
+        REQUIRE( count == index->get_tag_count() );
+
+        auto& bitmap_tag = index->get_tag(4);
+        auto& shape_tag = index->get_tag(5);
+        REQUIRE( bitmap_tag.code == TagCode::DEFINE_BITS_LOSSLESS2 );
+        REQUIRE( shape_tag.code == TagCode::DEFINE_SHAPE4 );
+
+        auto find = [&](TagCode code) -> const CharacterCost*
+        {
+            for( auto& cost : report.characters )
+                if( cost.code == code ) return &cost;
+            return nullptr;
+        };
+
+        auto bitmap = find(TagCode::DEFINE_BITS_LOSSLESS2);
+        REQUIRE( bitmap != nullptr );
+        REQUIRE( bitmap->bytes_consumed == bitmap_tag.size );
+        REQUIRE( bitmap->bytes_allocated > 0 );
+        REQUIRE( bitmap->phases[LOAD_PHASE_INFLATE] > 0 );
+        REQUIRE( bitmap->phases[LOAD_PHASE_INFLATE] <= bitmap->nanoseconds );
+
+        auto shape = find(TagCode::DEFINE_SHAPE4);
+        REQUIRE( shape != nullptr );
+        REQUIRE( shape->bytes_allocated > 0 );
+        REQUIRE( shape->phases[LOAD_PHASE_PARSE_BITS] > 0 );
+        REQUIRE( shape->phases[LOAD_PHASE_TESSELLATE] > 0 );
+        REQUIRE( shape->phases[LOAD_PHASE_PARSE_BITS] + shape->phases[LOAD_PHASE_CONTOURS] +
+            shape->phases[LOAD_PHASE_TESSELLATE] <= shape->nanoseconds );
+
+        // textures are uploaded on first render, not counted in decoding
+        for( auto& cost : report.characters )
+            REQUIRE( cost.phases[LOAD_PHASE_TEXTURE_UPLOAD] == 0 );
+
+        // the most expensive characters come first
+        for( auto i=1; i<report.characters.size(); i++ )
+            REQUIRE( report.characters[i-1].nanoseconds +
+                report.characters[i-1].phases[LOAD_PHASE_TEXTURE_UPLOAD] >=
+                report.characters[i].nanoseconds +
+                report.characters[i].phases[LOAD_PHASE_TEXTURE_UPLOAD] );
+
+        delete player;
+    }
+}
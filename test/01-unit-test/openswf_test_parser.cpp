@@ -1,4 +1,14 @@
 #include "openswf_test.hpp"
+#include "avm/script_object.hpp"
+#include "avm/virtual_machine.hpp"
+#include "avm/action_translator.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <vector>
 
 using namespace openswf;
 
@@ -54,6 +64,789 @@ TEST_CASE("PARSE_TAG_HEADER", "[OPENSWF]")
     REQUIRE( stream.is_finished() );
 }
 
+TEST_CASE("TAG_INDEX", "[OPENSWF]")
+{
+    SECTION( "tags, characters and frames of root movie" )
+    {
+        auto stream = create_from_file("../test/resources/simple-timeline-1.swf");
+        auto index = TagIndex::create(stream);
+        REQUIRE( index != nullptr );
+        REQUIRE( index->get_tag_count() == 14 );
+        REQUIRE( index->get_tag(0).code == TagCode::FILE_ATTRIBUTES );
+        REQUIRE( index->get_tag(13).code == TagCode::END );
+
+        auto& shape = index->get_tag(4);
+        REQUIRE( shape.code == TagCode::DEFINE_SHAPE );
+        REQUIRE( shape.size == 55 );
+
+        stream.set_position(shape.offset);
+        auto cid = stream.read_uint16();
+        REQUIRE( index->find_character(cid) == 4 );
+        REQUIRE( index->get_character(cid) == &shape );
+        REQUIRE( index->get_character(0xffff) == nullptr );
+
+        uint32_t first, last;
+        REQUIRE( index->get_frame_count() == 3 );
+        REQUIRE( index->get_frame(0, 1, first, last) );
+        REQUIRE( first == 0 );
+        REQUIRE( last == 7 );
+        REQUIRE( index->get_frame(0, 3, first, last) );
+        REQUIRE( first == 10 );
+        REQUIRE( last == 13 );
+        REQUIRE( !index->get_frame(0, 4, first, last) );
+        REQUIRE( !index->get_frame(0, 0, first, last) );
+    }
+
+    SECTION( "nested tags of sprite" )
+    {
+        uint8_t buffer[] = {
+            'F', 'W', 'S', 10, 29, 0, 0, 0,         // signature, version, file length
+            0x00, 0x00, 0x18, 0x01, 0x00,           // frame size, frame rate, frame count
+            0xca, 0x09, 0x07, 0x00, 0x02, 0x00,     // DefineSprite, id: 7, frame count: 2
+            0x40, 0x00, 0x40, 0x00, 0x00, 0x00,     // ShowFrame, ShowFrame, End
+            0x40, 0x00, 0x00, 0x00                  // ShowFrame, End
+        };
+
+        auto stream = Stream(buffer, sizeof(buffer));
+        auto index = TagIndex::create(stream);
+        REQUIRE( index != nullptr );
+        REQUIRE( index->get_tag_count() == 6 );
+        REQUIRE( index->find_character(7) == 0 );
+        REQUIRE( index->has_movie(7) );
+        REQUIRE( !index->has_movie(8) );
+
+        uint32_t first, last;
+        REQUIRE( index->get_frame_count(0) == 1 );
+        REQUIRE( index->get_frame(0, 1, first, last) );
+        REQUIRE( first == 0 );
+        REQUIRE( last == 5 );
+
+        REQUIRE( index->get_frame_count(7) == 2 );
+        REQUIRE( index->get_frame(7, 2, first, last) );
+        REQUIRE( first == 2 );
+        REQUIRE( last == 3 );
+    }
+}
+
+TEST_CASE("ACTION_BLOCK", "[OPENSWF]")
+{
+    uint8_t buffer[] = {
+        0x88, 0x06, 0x00, 0x02, 0x00, 'a', 0x00, 'b', 0x00,    // ConstantPool "a", "b"
+        0x96, 0x09, 0x00, 0x08, 0x01, 0x05, 0x01,               // Push constant 1, true,
+                    0x07, 0x02, 0x00, 0x00, 0x00,               //      integer 2
+        0x9D, 0x02, 0x00, 0x06, 0x00,                           // If +6
+        0x99, 0x02, 0x00, 0x02, 0x00,                           // Jump +2, to End
+        0x07,                                                   // Stop
+        0x17,                                                   // Pop
+        0x00,                                                   // End
+        0x06 };                                                 // Play, after End
+
+    AtomTable atoms;
+    auto block = avm::ActionBlock::compile(buffer, sizeof(buffer), atoms);
+    REQUIRE( block != nullptr );
+    REQUIRE( block->get_record_count() == 6 );
+
+    // strings of constant pool are interned
+    auto& constants = block->get_record(0);
+    REQUIRE( constants.code == avm::Opcode::CONSTANT_POOL );
+    REQUIRE( constants.count == 2 );
+    REQUIRE( block->get_atom(constants.operand+1) == atoms.intern("b") );
+    REQUIRE( atoms.size() == 2 );
+
+    auto& push = block->get_record(1);
+    REQUIRE( push.code == avm::Opcode::PUSH );
+    REQUIRE( push.count == 3 );
+    REQUIRE( block->get_operand(push.operand).type == avm::OpPushCode::CONSTANT8 );
+    REQUIRE( block->get_operand(push.operand).index == 1 );
+    REQUIRE( block->get_operand(push.operand+1).value.to_boolean() );
+    REQUIRE( block->get_operand(push.operand+2).value.to_integer() == 2 );
+
+    // branches are resolved into the indices of records
+    REQUIRE( block->get_record(2).code == avm::Opcode::IF );
+    REQUIRE( block->get_record(2).operand == 5 );
+    REQUIRE( block->get_record(3).code == avm::Opcode::JUMP );
+    REQUIRE( block->get_record(3).operand == block->get_record_count() );
+    REQUIRE( block->get_record(5).code == avm::Opcode::POP );
+    REQUIRE( block->get_record(5).handler != block->get_record(4).handler );
+    // a branch before the start of block ends it, instead of looping
+    uint8_t backward[] = {
+        0x06,                                                   // Play
+        0x99, 0x02, 0x00, 0xF0, 0xFF,                           // Jump -16
+        0x07,                                                   // Stop
+        0x00 };
+
+    block = avm::ActionBlock::compile(backward, sizeof(backward), atoms);
+    REQUIRE( block != nullptr );
+    REQUIRE( block->get_record_count() == 3 );
+    REQUIRE( block->get_record(1).code == avm::Opcode::JUMP );
+    REQUIRE( block->get_record(1).operand == block->get_record_count() );
+}
+
+TEST_CASE("COMPUTED_NAMES", "[OPENSWF]")
+{
+    uint8_t buffer[] = {
+        0x96, 0x05, 0x00, 0x01, 0x00, 0x00, 0xA0, 0x40,         // Push 5
+        0x1C,                                                   // GetVariable
+        0x96, 0x0A, 0x00, 0x01, 0x00, 0x00, 0xE0, 0x40,         // Push 7, 1
+                    0x01, 0x00, 0x00, 0x80, 0x3F,
+        0x1D,                                                   // SetVariable
+        0x96, 0x05, 0x00, 0x01, 0x00, 0x00, 0xE0, 0x40,         // Push 7
+        0x1C,                                                   // GetVariable
+        0x00 };
+
+    AtomTable atoms;
+    avm::VirtualMachine vm(atoms);
+    auto block = avm::ActionBlock::compile(buffer, sizeof(buffer), atoms);
+    REQUIRE( block != nullptr );
+    REQUIRE( atoms.size() == 0 );
+
+    // names computed at runtime are interned by stores only
+    avm::ContextObject context(vm.get_root_layout());
+    avm::MovieEnvironment env(&vm, &context, block.get());
+    avm::ContextObject::interpret(env);
+    REQUIRE( env.get_current_op() == 2 );
+    REQUIRE( env.get_operand(0).get_type() == avm::ValueCode::UNDEFINED );
+    REQUIRE( env.get_operand(1).to_number() == 1 );
+    REQUIRE( atoms.size() == 1 );
+    REQUIRE( atoms.find("7", 1) == atoms.intern("7") );
+    REQUIRE( atoms.find("5", 1).empty() );
+}
+
+// i = 0, while( i < 10 ) i = i + 1, the body of loop is 12 actions
+static const uint8_t s_loop_actions[] = {
+    0x96, 0x08, 0x00, 0x00, 'i', 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,   // i = 0
+    0x1D,
+    0x96, 0x03, 0x00, 0x00, 'i', 0x00,                                  // while( i < 10 )
+    0x1C,
+    0x96, 0x05, 0x00, 0x01, 0x00, 0x00, 0x20, 0x41,
+    0x0F,
+    0x12,
+    0x9D, 0x02, 0x00, 0x19, 0x00,
+    0x96, 0x06, 0x00, 0x00, 'i', 0x00, 0x00, 'i', 0x00,                 //     i = i + 1
+    0x1C,
+    0x96, 0x05, 0x00, 0x01, 0x00, 0x00, 0x80, 0x3F,
+    0x0A,
+    0x1D,
+    0x99, 0x02, 0x00, 0xD1, 0xFF };
+
+// the loop between other actions, its branches are relative
+static std::vector<uint8_t> make_loop(std::initializer_list<uint8_t> before, std::initializer_list<uint8_t> after)
+{
+    std::vector<uint8_t> buffer(before);
+    buffer.insert(buffer.end(), std::begin(s_loop_actions), std::end(s_loop_actions));
+    buffer.insert(buffer.end(), after);
+    return buffer;
+}
+
+TEST_CASE("NATIVE_BLOCK", "[OPENSWF]")
+{
+    auto buffer = make_loop({}, {
+        0x96, 0x03, 0x00, 0x00, 'i', 0x00,  // push i
+        0x1C,
+        0x00 });
+
+    AtomTable atoms;
+    avm::VirtualMachine vm(atoms);
+    auto block = avm::ActionBlock::compile(buffer.data(), buffer.size(), atoms);
+    REQUIRE( block != nullptr );
+
+    avm::ContextObject interpreted(vm.get_root_layout()), compiled(vm.get_root_layout());
+    avm::MovieEnvironment expected(&vm, &interpreted, block.get());
+    avm::ContextObject::interpret(expected);
+    REQUIRE( expected.get_current_op() == 1 );
+    REQUIRE( expected.get_operand(0).to_number() == 10 );
+
+    // native code leaves the same stack and variables
+    avm::MovieEnvironment env(&vm, &compiled, block.get());
+    auto native = avm::NativeBlock::compile(*block, env);
+#if OPENSWF_JIT
+    REQUIRE( native != nullptr );
+    native->run(env);
+    REQUIRE( env.next == expected.next );
+    REQUIRE( env.get_current_op() == 1 );
+    REQUIRE( env.get_operand(0).to_number() == 10 );
+    REQUIRE( compiled.get_layout() == interpreted.get_layout() );
+    REQUIRE( compiled.get_variable(atoms.intern("i")).to_number() == 10 );
+#else
+    REQUIRE( native == nullptr );
+#endif
+
+    // a block executed often enough is compiled, and checked against
+    // interpreter every time in differential mode
+    REQUIRE( initialize_parser() );
+    auto player = Player::create_from_file("../test/resources/simple-timeline-1.swf");
+    REQUIRE( player != nullptr );
+
+    auto& machine = player->get_virtual_machine();
+    auto context = player->get_root().get_context();
+    auto i = player->get_atoms().intern("i");
+    auto loop = make_loop({}, { 0x00 });
+    auto hot = avm::ActionBlock::compile(loop.data(), loop.size(), player->get_atoms());
+    REQUIRE( hot != nullptr );
+
+    machine.set_jit_mode(avm::JitMode::DIFFERENTIAL);
+    for( auto n=0; n<20; n++ )
+    {
+        context->set_variable(i, avm::Value().set_integer(-1));
+        machine.execute(context, *hot);
+        REQUIRE( machine.get_suspended_count() == 0 );
+        REQUIRE( context->get_variable(i).to_number() == 10 );
+    }
+
+    avm::MovieEnvironment probe(&machine, context, hot.get());
+#if OPENSWF_JIT
+    REQUIRE( hot->get_native(probe) != nullptr );
+#else
+    REQUIRE( hot->get_native(probe) == nullptr );
+#endif
+    delete player;
+}
+
+TEST_CASE("SCRIPT_BUDGET", "[OPENSWF]")
+{
+    auto buffer = make_loop({}, {
+        0x96, 0x03, 0x00, 0x00, 'i', 0x00,  // push i
+        0x1C,
+        0x00 });
+
+    AtomTable atoms;
+    avm::VirtualMachine vm(atoms);
+    auto block = avm::ActionBlock::compile(buffer.data(), buffer.size(), atoms);
+    REQUIRE( block != nullptr );
+
+    // the body of loop is 12 actions, so its suspended at the second jump
+    vm.set_instruction_budget(20);
+
+    avm::ContextObject context(vm.get_root_layout());
+    avm::MovieEnvironment env(&vm, &context, block.get());
+    avm::ContextObject::interpret(env);
+    REQUIRE( env.status == avm::ExecutionStatus::SUSPENDED );
+    REQUIRE( env.next == 2 );
+    REQUIRE( context.get_variable(atoms.intern("i")).to_number() == 2 );
+
+    // and resumed from there, two iterations a frame
+    int frames = 1;
+    while( env.status == avm::ExecutionStatus::SUSPENDED )
+    {
+        vm.update();
+        env.status = avm::ExecutionStatus::RUNNING;
+        avm::ContextObject::interpret(env);
+        frames ++;
+    }
+
+    REQUIRE( env.status == avm::ExecutionStatus::RUNNING );
+    REQUIRE( frames == 6 );
+    REQUIRE( env.get_current_op() == 1 );
+    REQUIRE( env.get_operand(0).to_number() == 10 );
+
+#if OPENSWF_JIT
+    // native code returns to the interpreter at the same branch
+    vm.update();
+    avm::ContextObject compiled(vm.get_root_layout());
+    avm::MovieEnvironment native_env(&vm, &compiled, block.get());
+    auto native = avm::NativeBlock::compile(*block, native_env);
+    REQUIRE( native != nullptr );
+    native->run(native_env);
+    REQUIRE( native_env.status == avm::ExecutionStatus::SUSPENDED );
+    REQUIRE( native_env.next == 2 );
+    REQUIRE( compiled.get_variable(atoms.intern("i")).to_number() == 2 );
+#endif
+
+    // an unlimited budget runs it through
+    vm.set_instruction_budget(0);
+    avm::ContextObject unlimited(vm.get_root_layout());
+    avm::MovieEnvironment full(&vm, &unlimited, block.get());
+    avm::ContextObject::interpret(full);
+    REQUIRE( full.status == avm::ExecutionStatus::RUNNING );
+    REQUIRE( full.get_operand(0).to_number() == 10 );
+}
+
+TEST_CASE("SCRIPT_PROFILER", "[OPENSWF]")
+{
+    REQUIRE( initialize_parser() );
+    auto player = Player::create_from_file("../test/resources/simple-timeline-1.swf");
+    REQUIRE( player != nullptr );
+
+    auto& vm = player->get_virtual_machine();
+    REQUIRE( vm.get_profiler() == nullptr );
+
+    auto buffer = make_loop({}, { 0x00 });
+    auto block = avm::ActionBlock::compile(buffer.data(), buffer.size(), player->get_atoms());
+    REQUIRE( block != nullptr );
+    block->set_origin(3, 7);
+
+    vm.set_profiling(true);
+    auto profiler = vm.get_profiler();
+    REQUIRE( profiler != nullptr );
+
+    // a block suspended by budget is called once, and resumed by frames
+    vm.set_instruction_budget(20);
+    auto context = player->get_root().get_context();
+    vm.execute(context, *block);
+    REQUIRE( vm.get_suspended_count() == 1 );
+
+    int frames = 1;
+    while( vm.get_suspended_count() > 0 )
+    {
+        vm.update();
+        frames ++;
+    }
+
+    REQUIRE( frames == 6 );
+    REQUIRE( context->get_variable(player->get_atoms().intern("i")).to_number() == 10 );
+
+    auto report = profiler->get_report();
+    REQUIRE( report.blocks.size() == 1 );
+    REQUIRE( report.blocks[0].character_id == 3 );
+    REQUIRE( report.blocks[0].frame == 7 );
+    REQUIRE( report.blocks[0].records == block->get_record_count() );
+    REQUIRE( report.blocks[0].calls == 1 );
+
+    // every action interpreted is counted, and the cycles of block include
+    // the ones of its actions over all the frames
+    uint64_t actions = 0, cycles = 0;
+    for( size_t i=0; i<report.opcodes.size(); i++ )
+    {
+        auto& cost = report.opcodes[i];
+        if( i > 0 ) REQUIRE( report.opcodes[i-1].cycles >= cost.cycles );
+        if( cost.code == avm::Opcode::ADD ) REQUIRE( cost.count == 10 );
+        if( cost.code == avm::Opcode::JUMP ) REQUIRE( cost.count == 10 );
+        if( cost.code == avm::Opcode::IF ) REQUIRE( cost.count == 11 );
+        actions += cost.count;
+        cycles += cost.cycles;
+    }
+    REQUIRE( actions == 2 + 12 * 10 + 6 );
+    REQUIRE( report.blocks[0].cycles >= cycles );
+
+    // and called again once its finished
+    vm.set_instruction_budget(0);
+    vm.execute(context, *block);
+    REQUIRE( vm.get_suspended_count() == 0 );
+    REQUIRE( profiler->get_report().blocks[0].calls == 2 );
+
+    auto json = report.to_json();
+    REQUIRE( json.find("\"character_id\": 3, \"frame\": 7") != std::string::npos );
+    REQUIRE( json.find("\"opcode\": \"ADD\", \"code\": 10, \"count\": 10,") != std::string::npos );
+    REQUIRE( report.to_string().find("ADD") != std::string::npos );
+
+    vm.set_profiling(false);
+    REQUIRE( vm.get_profiler() == nullptr );
+    REQUIRE( avm::ScriptReport().to_json() == "{\n  \"blocks\": [],\n  \"opcodes\": []\n}\n" );
+    delete player;
+}
+
+static bool is_identical(avm::Value a, avm::Value b)
+{
+    return memcmp(&a, &b, sizeof(avm::Value)) == 0;
+}
+
+TEST_CASE("ACTION_OPTIMIZER", "[OPENSWF]")
+{
+    auto buffer = make_loop({
+        0x96, 0x08, 0x00, 0x00, 'c', 0x00, 0x07, 0x01, 0x00, 0x00, 0x00,                                 // c = 1
+        0x1D,
+        0x96, 0x0D, 0x00, 0x00, 'r', 0x00, 0x07, 0x06, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00,   // r = 6 / 0
+        0x0D,
+        0x1D,
+        0x96, 0x0D, 0x00, 0x00, 's', 0x00, 0x07, 0x03, 0x00, 0x00, 0x00, 0x07, 0x04, 0x00, 0x00, 0x00,   // s = (3 + 4) * 2.5 < 7
+        0x0A,
+        0x96, 0x05, 0x00, 0x01, 0x00, 0x00, 0x20, 0x40,
+        0x0C,
+        0x96, 0x05, 0x00, 0x07, 0x07, 0x00, 0x00, 0x00,
+        0x0F,
+        0x1D,
+        0x96, 0x0A, 0x00, 0x07, 0x01, 0x00, 0x00, 0x00, 0x07, 0x02, 0x00, 0x00, 0x00,                    // push and pop
+        0x17,
+        0x96, 0x05, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00,                                                  // if( !0 ) skip
+        0x12,
+        0x9D, 0x02, 0x00, 0x0C, 0x00,
+        0x96, 0x08, 0x00, 0x00, 'x', 0x00, 0x07, 0x6F, 0x00, 0x00, 0x00,
+        0x1D,
+        0x96, 0x08, 0x00, 0x07, 0x01, 0x00, 0x00, 0x00, 0x00, 'c', 0x00,                                 // c ? 1 + 3 : 1, 2 + 3
+        0x1C,
+        0x9D, 0x02, 0x00, 0x08, 0x00,
+        0x96, 0x05, 0x00, 0x07, 0x02, 0x00, 0x00, 0x00,
+        0x96, 0x05, 0x00, 0x07, 0x03, 0x00, 0x00, 0x00,
+        0x0A }, {
+        0x96, 0x03, 0x00, 0x00, 'r', 0x00,                                                               // push r, s, i
+        0x1C,
+        0x96, 0x03, 0x00, 0x00, 's', 0x00,
+        0x1C,
+        0x96, 0x03, 0x00, 0x00, 'i', 0x00,
+        0x1C,
+        0x00 });
+
+    // the optimized block leaves the same stack and variables, bit by bit
+    for( auto version : { 4, 10 } )
+    {
+        AtomTable atoms;
+        avm::VirtualMachine vm(atoms, version);
+        auto plain = avm::ActionBlock::compile(buffer.data(), buffer.size(), atoms);
+        auto optimized = avm::ActionBlock::compile(buffer.data(), buffer.size(), atoms, version);
+        REQUIRE( plain != nullptr );
+        REQUIRE( optimized != nullptr );
+        REQUIRE( optimized->get_record_count() < plain->get_record_count() );
+
+        // the superinstructions take the place of plain actions
+        auto count_of = [](const avm::ActionBlock& block, avm::Opcode code)
+        {
+            auto count = 0;
+            for( uint32_t i=0; i<block.get_record_count(); i++ )
+                if( block.get_record(i).code == code ) count ++;
+            return count;
+        };
+
+        REQUIRE( count_of(*plain, avm::Opcode::IF_NOT) == 0 );
+        REQUIRE( count_of(*plain, avm::Opcode::PUSH_GET_VARIABLE) == 0 );
+        REQUIRE( count_of(*optimized, avm::Opcode::IF_NOT) == 1 );
+        REQUIRE( count_of(*optimized, avm::Opcode::NOT) == 0 );
+        REQUIRE( count_of(*optimized, avm::Opcode::PUSH_GET_VARIABLE) == 6 );
+        REQUIRE( count_of(*optimized, avm::Opcode::GET_VARIABLE) == 0 );
+
+        auto source = avm::ActionTranslator::translate(*optimized, "optimized");
+        REQUIRE( source.find("if( env.pop().to_number() == 0 )") != std::string::npos );
+
+        avm::ContextObject expected_context(vm.get_root_layout()), context(vm.get_root_layout());
+        avm::MovieEnvironment expected(&vm, &expected_context, plain.get());
+        avm::MovieEnvironment env(&vm, &context, optimized.get());
+        avm::ContextObject::interpret(expected);
+        avm::ContextObject::interpret(env);
+
+        REQUIRE( expected.get_current_op() == 5 );
+        REQUIRE( expected.get_operand(1).to_number() == 4 );
+        REQUIRE( expected.get_operand(4).to_number() == 10 );
+        REQUIRE( env.get_current_op() == expected.get_current_op() );
+        for( auto i=0; i<env.get_current_op(); i++ )
+            REQUIRE( is_identical(env.get_operand(i), expected.get_operand(i)) );
+
+        for( auto name : { "c", "r", "s", "x", "i" } )
+        {
+            REQUIRE( is_identical(context.get_variable(atoms.intern(name)),
+                expected_context.get_variable(atoms.intern(name))) );
+        }
+
+#if OPENSWF_JIT
+        avm::ContextObject native_context(vm.get_root_layout());
+        avm::MovieEnvironment native_env(&vm, &native_context, optimized.get());
+        auto native = avm::NativeBlock::compile(*optimized, native_env);
+        REQUIRE( native != nullptr );
+        native->run(native_env);
+        REQUIRE( native_env.get_current_op() == expected.get_current_op() );
+        for( auto i=0; i<native_env.get_current_op(); i++ )
+            REQUIRE( is_identical(native_env.get_operand(i), expected.get_operand(i)) );
+#endif
+    }
+}
+
+static int s_precompiled_runs = 0;
+static void precompiled_stop(avm::MovieEnvironment&)
+{
+    s_precompiled_runs ++;
+}
+
+TEST_CASE("PRECOMPILED_ACTIONS", "[OPENSWF]")
+{
+    uint8_t buffer[] = {
+        0x96, 0x0A, 0x00, 0x01, 0x00, 0x00, 0x80, 0x3F, 0x01, 0x00, 0x00, 0x00, 0x40,  // Push 1, 2
+        0x0A,                                                                       // Add
+        0x9D, 0x02, 0x00, 0x01, 0x00,                                               // If +1
+        0x07,                                                                       // Stop
+        0x00 };
+
+    // branches are translated into gotos, other actions call their handlers
+    avm::ActionTranslator translator;
+    REQUIRE( translator.add(buffer, sizeof(buffer)) );
+    REQUIRE( translator.add(buffer, sizeof(buffer)) );
+    REQUIRE( translator.get_function_count() == 1 );
+
+    auto source = translator.get_source();
+    REQUIRE( source.find("env.push(Value().set_number(1));") != std::string::npos );
+    REQUIRE( source.find("if( env.pop().to_boolean() ) goto finish;") != std::string::npos );
+    REQUIRE( source.find("env.record = &block->get_record(3);") != std::string::npos );
+    REQUIRE( source.find("static PrecompiledRegistrar s_registrar(s_entries, 1);") != std::string::npos );
+
+    REQUIRE( source.find("static const uint8_t actions_") != std::string::npos );
+    REQUIRE( source.find("    0x96, 0x0A, 0x00, 0x01, 0x00, 0x00, 0x80, 0x3F,") != std::string::npos );
+
+    // blocks of the registered bytecode run the function
+    std::vector<uint8_t> bytes(buffer, buffer+sizeof(buffer));
+    avm::PrecompiledEntry entry = {
+        avm::PrecompiledRegistry::hash(buffer, sizeof(buffer)), sizeof(buffer), bytes.data(), precompiled_stop };
+    AtomTable atoms;
+    {
+        avm::PrecompiledRegistrar registrar(&entry, 1);
+        auto block = avm::ActionBlock::compile(buffer, sizeof(buffer), atoms);
+        REQUIRE( block != nullptr );
+        REQUIRE( block->get_precompiled() == precompiled_stop );
+
+        buffer[6] = 0x00;
+        block = avm::ActionBlock::compile(buffer, sizeof(buffer), atoms);
+        REQUIRE( block->get_precompiled() == nullptr );
+        buffer[6] = 0x80;
+    }
+
+    // and unregistered with the registrar
+    auto block = avm::ActionBlock::compile(buffer, sizeof(buffer), atoms);
+    REQUIRE( block != nullptr );
+    REQUIRE( block->get_precompiled() == nullptr );
+
+    // bytecode of the same hash and size is compared before running it
+    auto other = bytes;
+    other[6] = 0x00;
+    avm::PrecompiledEntry collision = { entry.hash, entry.size, other.data(), precompiled_stop };
+    {
+        avm::PrecompiledRegistrar registrar(&collision, 1);
+        block = avm::ActionBlock::compile(buffer, sizeof(buffer), atoms);
+        REQUIRE( block->get_precompiled() == nullptr );
+    }
+}
+
+TEST_CASE("TRANSLATED_ACTIONS", "[OPENSWF]")
+{
+    auto buffer = make_loop({
+        0x88, 0x04, 0x00, 0x01, 0x00, 'k', 0x00,                                   // constants k
+        0x96, 0x07, 0x00, 0x08, 0x00, 0x07, 0x03, 0x00, 0x00, 0x00,                // k = 3
+        0x1D,
+        0x96, 0x09, 0x00, 0x05, 0x01, 0x02, 0x03, 0x01, 0x00, 0x00, 0x20, 0x40,    // push true, null, undefined, 2.5 and pop
+        0x17 }, {
+        0x96, 0x03, 0x00, 0x00, 'i', 0x00,                                         // push (i - 0.5) * k
+        0x1C,
+        0x96, 0x05, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3F,
+        0x0B,
+        0x96, 0x03, 0x00, 0x00, 'k', 0x00,
+        0x1C,
+        0x0C,
+        0x99, 0x02, 0x00, 0x08, 0x00,                                              // skip push 111
+        0x96, 0x05, 0x00, 0x07, 0x6F, 0x00, 0x00, 0x00,
+        0x96, 0x02, 0x00, 0x05, 0x00,                                              // if( false ) skip push 222
+        0x9D, 0x02, 0x00, 0x08, 0x00,
+        0x96, 0x05, 0x00, 0x07, 0xDE, 0x00, 0x00, 0x00,
+        0x00 });
+
+    // precompiled_actions.cpp is the source translated from the buffer, its
+    // regenerated with the translator once this fails
+    avm::ActionTranslator translator;
+    REQUIRE( translator.add(buffer.data(), buffer.size()) );
+    std::ifstream file("../test/01-unit-test/precompiled_actions.cpp");
+    REQUIRE( file.is_open() );
+    std::stringstream generated;
+    generated << file.rdbuf();
+    REQUIRE( generated.str() == translator.get_source() );
+
+    // and its compiled in, so the function leaves the same stack and
+    // variables as interpreter, bit by bit
+    AtomTable atoms;
+    avm::VirtualMachine vm(atoms);
+    auto block = avm::ActionBlock::compile(buffer.data(), buffer.size(), atoms);
+    REQUIRE( block != nullptr );
+    REQUIRE( block->get_precompiled() != nullptr );
+
+    avm::ContextObject expected_context(vm.get_root_layout()), context(vm.get_root_layout());
+    avm::MovieEnvironment expected(&vm, &expected_context, block.get());
+    avm::MovieEnvironment env(&vm, &context, block.get());
+    avm::ContextObject::interpret(expected);
+    block->get_precompiled()(env);
+
+    REQUIRE( expected.get_current_op() == 5 );
+    REQUIRE( expected.get_operand(0).to_boolean() );
+    REQUIRE( expected.get_operand(3).to_number() == 28.5 );
+    REQUIRE( expected.get_operand(4).to_number() == 222 );
+    REQUIRE( env.status == expected.status );
+    REQUIRE( env.get_current_op() == expected.get_current_op() );
+    for( auto i=0; i<env.get_current_op(); i++ )
+        REQUIRE( is_identical(env.get_operand(i), expected.get_operand(i)) );
+
+    for( auto name : { "k", "i" } )
+    {
+        REQUIRE( is_identical(context.get_variable(atoms.intern(name)),
+            expected_context.get_variable(atoms.intern(name))) );
+    }
+    REQUIRE( context.get_variable(atoms.intern("i")).to_number() == 10 );
+}
+
+TEST_CASE("OBJECT_LAYOUT", "[OPENSWF]")
+{
+    AtomTable atoms;
+    auto x = atoms.intern("x");
+    auto y = atoms.intern("y");
+
+    // objects adding the same properties in order share the layout
+    avm::ObjectLayout root;
+    avm::ScriptObject a(&root), b(&root);
+    a.set_variable(x, avm::Value().set_integer(1));
+    a.set_variable(y, avm::Value().set_integer(2));
+    b.set_variable(x, avm::Value().set_integer(3));
+    b.set_variable(y, avm::Value().set_integer(4));
+    REQUIRE( a.get_layout() == b.get_layout() );
+    REQUIRE( a.get_layout()->get_slot_count() == 2 );
+    REQUIRE( a.get_layout()->find(y) == 1 );
+
+    avm::ScriptObject c(&root);
+    c.set_variable(y, avm::Value().set_integer(5));
+    REQUIRE( c.get_layout() != a.get_layout() );
+    REQUIRE( c.get_layout()->find(y) == 0 );
+
+    // the cache of a site follows the transition, and hits on the same layout
+    avm::PropertyCache cache;
+    REQUIRE( a.get_variable(y, cache).to_integer() == 2 );
+    REQUIRE( cache.layout == a.get_layout() );
+    REQUIRE( b.get_variable(y, cache).to_integer() == 4 );
+    REQUIRE( c.get_variable(y, cache).to_integer() == 5 );
+    REQUIRE( cache.layout == c.get_layout() );
+    REQUIRE( c.get_variable(x, cache).get_type() == avm::ValueCode::UNDEFINED );
+
+    avm::PropertyCache store;
+    avm::ScriptObject d(&root), e(&root);
+    d.set_variable(x, avm::Value().set_integer(6), store);
+    REQUIRE( store.layout == &root );
+    REQUIRE( store.transition == d.get_layout() );
+    e.set_variable(x, avm::Value().set_integer(7), store);
+    REQUIRE( e.get_layout() == d.get_layout() );
+    REQUIRE( e.get_variable(x).to_integer() == 7 );
+
+    // each transition takes one layout, an object with too many properties
+    // moves into a dictionary of its own
+    REQUIRE( root.get_tree_size() == 4 );
+    avm::ObjectLayout tree;
+    avm::ScriptObject f(&tree);
+    for( int i=0; i<1000; i++ )
+        f.set_variable(atoms.intern(std::to_string(i)), avm::Value().set_integer(i));
+    REQUIRE( tree.get_tree_size() == 65 );
+    REQUIRE( f.get_layout()->is_dictionary() );
+    REQUIRE( f.get_layout()->get_slot_count() == 1000 );
+    REQUIRE( f.get_layout()->find(atoms.intern("0")) == 0 );
+    REQUIRE( f.get_variable(atoms.intern("999")).to_integer() == 999 );
+    REQUIRE( f.get_layout()->find(x) < 0 );
+
+    // dictionaries are changed in place, so sites do not cache them
+    avm::PropertyCache site;
+    REQUIRE( f.get_variable(atoms.intern("500"), site).to_integer() == 500 );
+    REQUIRE( site.layout == nullptr );
+    f.set_variable(x, avm::Value().set_integer(8), site);
+    f.set_variable(x, avm::Value().set_integer(9), site);
+    REQUIRE( site.layout == nullptr );
+    REQUIRE( f.get_layout()->get_slot_count() == 1001 );
+    REQUIRE( f.get_variable(x, site).to_integer() == 9 );
+
+    // a layout branching off a chain has the names before it only
+    avm::ScriptObject g(&tree);
+    g.set_variable(atoms.intern("0"), avm::Value().set_integer(0));
+    g.set_variable(y, avm::Value().set_integer(1));
+    REQUIRE( g.get_layout()->find(y) == 1 );
+    REQUIRE( g.get_layout()->find(atoms.intern("1")) < 0 );
+    REQUIRE( tree.get_tree_size() == 66 );
+
+    // objects adding the same names in different orders are bounded by tree
+    std::mt19937 random(7);
+    std::vector<Atom> names;
+    for( auto name : { "a", "b", "c", "d", "e", "f", "g" } )
+        names.push_back(atoms.intern(name));
+
+    avm::ObjectLayout orders;
+    std::vector<std::unique_ptr<avm::ScriptObject>> objects;
+    for( int i=0; i<2000; i++ )
+    {
+        std::shuffle(names.begin(), names.end(), random);
+        objects.emplace_back(new avm::ScriptObject(&orders));
+        for( size_t k=0; k<names.size(); k++ )
+            objects.back()->set_variable(names[k], avm::Value().set_integer(k));
+    }
+
+    REQUIRE( orders.get_tree_size() == 4096 );
+    for( auto& object : objects )
+    {
+        REQUIRE( object->get_layout()->get_slot_count() == names.size() );
+        for( size_t k=0; k<names.size(); k++ )
+            REQUIRE( object->get_variable(names[k]).get_type() == avm::ValueCode::INTEGER );
+    }
+}
+
+TEST_CASE("NAN_BOXED_VALUE", "[OPENSWF]")
+{
+    REQUIRE( sizeof(avm::Value) == 8 );
+    REQUIRE( avm::Value().get_type() == avm::ValueCode::UNDEFINED );
+
+    avm::Value value;
+    REQUIRE( value.set_number(-1.5).get_type() == avm::ValueCode::NUMBER );
+    REQUIRE( value.to_number() == -1.5 );
+    REQUIRE( value.set_number(-std::numeric_limits<double>::infinity()).get_type() == avm::ValueCode::NUMBER );
+    REQUIRE( value.set_number(-std::numeric_limits<double>::quiet_NaN()).get_type() == avm::ValueCode::NUMBER );
+    REQUIRE( value.to_number() != value.to_number() );
+
+    REQUIRE( value.set_integer(-7).get_type() == avm::ValueCode::INTEGER );
+    REQUIRE( value.to_integer() == -7 );
+    REQUIRE( value.to_number() == -7.0 );
+    REQUIRE( value.set_boolean(true).to_string() == "true" );
+    REQUIRE( value.to_integer() == 1 );
+    REQUIRE( value.set_object(nullptr).get_type() == avm::ValueCode::NULLPTR );
+
+    AtomTable atoms;
+    REQUIRE( value.set_atom(atoms.intern("hello")).get_type() == avm::ValueCode::STRING );
+    REQUIRE( value.to_atom() == atoms.intern("hello") );
+    REQUIRE( value.to_string() == "hello" );
+    REQUIRE( value.set_atom(Atom()).to_atom().empty() );
+
+    avm::ObjectLayout root;
+    avm::ScriptObject object(&root);
+    REQUIRE( value.set_object(&object).to_object() == &object );
+    REQUIRE( value.to_object<avm::ScriptObject>() == &object );
+    REQUIRE( value.to_number() == 0 );
+}
+
+struct TestMachine : public avm::VirtualMachine
+{
+    TestMachine(AtomTable& atoms) : avm::VirtualMachine(atoms) {}
+    using avm::VirtualMachine::minor_collect;
+    using avm::VirtualMachine::start_major;
+};
+
+TEST_CASE("GARBAGE_COLLECTOR", "[OPENSWF]")
+{
+    AtomTable atoms;
+    auto next = atoms.intern("next");
+
+    TestMachine vm(atoms);
+    vm.set_gc_budget(0);
+
+    // unreachable objects of nursery are freed without promotion
+    avm::ScriptObject* previous = nullptr;
+    for( int i=0; i<100; i++ )
+    {
+        auto object = vm.new_object<avm::ScriptObject>(vm.get_root_layout());
+        object->set_variable(next, avm::Value().set_object(previous));
+        previous = object;
+    }
+    REQUIRE( vm.get_object_count() == 100 );
+    vm.minor_collect();
+    REQUIRE( vm.get_object_count() == 0 );
+
+    // objects allocated while marking survive the cycle
+    vm.start_major();
+    REQUIRE( vm.get_gc_phase() == avm::GCPhase::MARK );
+    auto object = vm.new_object<avm::ScriptObject>(vm.get_root_layout());
+    REQUIRE( object->get_color() == avm::GCColor::BLACK );
+
+    // every call does a little work even out of budget
+    for( int i=0; i<4 && vm.get_gc_phase() != avm::GCPhase::IDLE; i++ )
+        vm.collect();
+    REQUIRE( vm.get_gc_phase() == avm::GCPhase::IDLE );
+    REQUIRE( vm.get_object_count() == 1 );
+    REQUIRE( object->is_old() );
+    REQUIRE( object->get_color() == avm::GCColor::WHITE );
+
+    // a young object stored into an old one is remembered by the write
+    // barrier, and survives a minor collection without other references
+    auto young = vm.new_object<avm::ScriptObject>(vm.get_root_layout());
+    object->set_variable(next, avm::Value().set_object(young));
+    vm.minor_collect();
+    REQUIRE( vm.get_object_count() == 2 );
+    REQUIRE( young->is_old() );
+    REQUIRE( object->get_variable(next).to_object() == young );
+
+    vm.gabarge_collect();
+    REQUIRE( vm.get_object_count() == 0 );
+}
+
 // TEST_CASE("DEFINE-SHAPE-PARSE", "[OPENSWF]")
 // {
 //     auto stream = create_from_file("../test/resources/simple-shape-1.swf");
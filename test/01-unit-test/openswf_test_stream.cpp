@@ -135,6 +135,31 @@ TEST_CASE( "STREAM_READ_BITS", "[OPENSWF]" )
         REQUIRE( records.read_bits_as_fixed32(18) == Approx(value/(double)65536.0) );
         REQUIRE( records.read_bits_as_int32(6) == -22 );
     }
+
+    SECTION( "cached bytes are given back when aligned" )
+    {
+        uint8_t buffer[16];
+        for( auto i=0; i<16; i++ ) buffer[i] = (uint8_t)(0x10 + i);
+
+        auto records = openswf::Stream(buffer, sizeof(buffer));
+        REQUIRE( records.read_bits_as_uint32(4) == 0x1 );
+        REQUIRE( records.get_bit_position() == 4 );
+        REQUIRE( records.get_position() == 1 );
+
+        records.align();
+        REQUIRE( records.get_position() == 1 );
+        REQUIRE( records.read_uint8() == 0x11 );
+
+        // crosses the boundary of cached 64 bits
+        REQUIRE( records.read_bits_as_uint32(32) == 0x12131415 );
+        REQUIRE( records.read_bits_as_uint32(32) == 0x16171819 );
+        REQUIRE( records.read_bits_as_uint32(24) == 0x1a1b1c );
+        REQUIRE( records.read_bits_as_uint32(0) == 0 );
+        REQUIRE( records.read_bits_as_int32(0) == 0 );
+        REQUIRE( records.read_uint16() == 0x1e1d );
+        REQUIRE( records.read_bits_as_uint32(8) == 0x1f );
+        REQUIRE( records.is_finished() );
+    }
 }
 
 TEST_CASE( "STREAM_READ_ENCODED_UINT32", "[OPENSWF]" )
@@ -187,3 +212,26 @@ TEST_CASE( "STREAM_READ_STRING", "[OPENSWF]" )
         REQUIRE( records.read_encoded_uint32() == 79 );
     }
 }
+
+TEST_CASE( "STREAM_FILE_SOURCE", "[OPENSWF]" )
+{
+    SECTION( "mapped bytes are the same as the file" )
+    {
+        auto expected = create_from_file("../test/resources/simple-shape-1.swf");
+        auto source = openswf::FileSource::create("../test/resources/simple-shape-1.swf");
+        REQUIRE( source != nullptr );
+        REQUIRE( source->get_size() == expected.get_size() );
+        REQUIRE( memcmp(source->get_data(), expected.get_current_ptr(), expected.get_size()) == 0 );
+
+        auto records = source->get_stream();
+        source->advise(openswf::FileAccess::SEQUENTIAL);
+        REQUIRE( records.read_uint8() == 'F' );
+        REQUIRE( records.read_uint8() == 'W' );
+        REQUIRE( records.read_uint8() == 'S' );
+    }
+
+    SECTION( "missing files are rejected" )
+    {
+        REQUIRE( openswf::FileSource::create("../test/resources/missing.swf") == nullptr );
+    }
+}
@@ -0,0 +1,130 @@
+// generated by the action compiler of openswf, do not edit.
+#include "avm/context_object.hpp"
+#include "avm/precompiled.hpp"
+
+#include <limits>
+
+using namespace openswf::avm;
+
+static void actions_d86301f6f2e97d2d(MovieEnvironment& env)
+{
+    auto block = env.block;
+    (void)block;
+
+    // CONSTANT_POOL
+    env.record = &block->get_record(0);
+    env.record->handler(env);
+    // PUSH
+    env.record = &block->get_record(1);
+    env.record->handler(env);
+    // SET_VARIABLE
+    env.record = &block->get_record(2);
+    env.record->handler(env);
+    // PUSH
+    env.push(Value().set_boolean(true));
+    env.push(Value().set_nil());
+    env.push(Value());
+    env.push(Value().set_number(2.5));
+    // POP
+    env.pop();
+    // PUSH
+    env.push(Value().set_atom(block->get_atom(1)));
+    env.push(Value().set_number(0));
+    // SET_VARIABLE
+    env.record = &block->get_record(6);
+    env.record->handler(env);
+L7:
+    // PUSH
+    env.push(Value().set_atom(block->get_atom(2)));
+    // GET_VARIABLE
+    env.record = &block->get_record(8);
+    env.record->handler(env);
+    // PUSH
+    env.push(Value().set_number(10));
+    // LESS
+    env.record = &block->get_record(10);
+    env.record->handler(env);
+    // NOT
+    env.record = &block->get_record(11);
+    env.record->handler(env);
+    // IF
+    if( env.pop().to_boolean() ) goto L19;
+    // PUSH
+    env.push(Value().set_atom(block->get_atom(3)));
+    env.push(Value().set_atom(block->get_atom(4)));
+    // GET_VARIABLE
+    env.record = &block->get_record(14);
+    env.record->handler(env);
+    // PUSH
+    env.push(Value().set_number(1));
+    // ADD
+    {
+        auto op1 = env.pop().to_number();
+        auto op2 = env.pop().to_number();
+        env.push(Value().set_number(op2 + op1));
+    }
+    // SET_VARIABLE
+    env.record = &block->get_record(17);
+    env.record->handler(env);
+    // JUMP
+    { env.next = 7; if( !env.charge(12) ) return; goto L7; }
+L19:
+    // PUSH
+    env.push(Value().set_atom(block->get_atom(5)));
+    // GET_VARIABLE
+    env.record = &block->get_record(20);
+    env.record->handler(env);
+    // PUSH
+    env.push(Value().set_number(0.5));
+    // SUBTRACT
+    {
+        auto op1 = env.pop().to_number();
+        auto op2 = env.pop().to_number();
+        env.push(Value().set_number(op2 - op1));
+    }
+    // PUSH
+    env.push(Value().set_atom(block->get_atom(6)));
+    // GET_VARIABLE
+    env.record = &block->get_record(24);
+    env.record->handler(env);
+    // MULTIPLY
+    {
+        auto op1 = env.pop().to_number();
+        auto op2 = env.pop().to_number();
+        env.push(Value().set_number(op2 * op1));
+    }
+    // JUMP
+    goto L28;
+    // PUSH
+    env.push(Value().set_integer(111));
+L28:
+    // PUSH
+    env.push(Value().set_boolean(false));
+    // IF
+    if( env.pop().to_boolean() ) goto finish;
+    // PUSH
+    env.push(Value().set_integer(222));
+finish:
+    return;
+}
+
+static const uint8_t actions_d86301f6f2e97d2d_bytes[] =
+{
+    0x88, 0x04, 0x00, 0x01, 0x00, 0x6B, 0x00, 0x96, 0x07, 0x00, 0x08, 0x00, 0x07, 0x03, 0x00, 0x00,
+    0x00, 0x1D, 0x96, 0x09, 0x00, 0x05, 0x01, 0x02, 0x03, 0x01, 0x00, 0x00, 0x20, 0x40, 0x17, 0x96,
+    0x08, 0x00, 0x00, 0x69, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x1D, 0x96, 0x03, 0x00, 0x00, 0x69,
+    0x00, 0x1C, 0x96, 0x05, 0x00, 0x01, 0x00, 0x00, 0x20, 0x41, 0x0F, 0x12, 0x9D, 0x02, 0x00, 0x19,
+    0x00, 0x96, 0x06, 0x00, 0x00, 0x69, 0x00, 0x00, 0x69, 0x00, 0x1C, 0x96, 0x05, 0x00, 0x01, 0x00,
+    0x00, 0x80, 0x3F, 0x0A, 0x1D, 0x99, 0x02, 0x00, 0xD1, 0xFF, 0x96, 0x03, 0x00, 0x00, 0x69, 0x00,
+    0x1C, 0x96, 0x05, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3F, 0x0B, 0x96, 0x03, 0x00, 0x00, 0x6B, 0x00,
+    0x1C, 0x0C, 0x99, 0x02, 0x00, 0x08, 0x00, 0x96, 0x05, 0x00, 0x07, 0x6F, 0x00, 0x00, 0x00, 0x96,
+    0x02, 0x00, 0x05, 0x00, 0x9D, 0x02, 0x00, 0x08, 0x00, 0x96, 0x05, 0x00, 0x07, 0xDE, 0x00, 0x00,
+    0x00, 0x00,
+};
+
+static const PrecompiledEntry s_entries[] =
+{
+    { 0xd86301f6f2e97d2dULL, 146, actions_d86301f6f2e97d2d_bytes, actions_d86301f6f2e97d2d },
+};
+
+static PrecompiledRegistrar s_registrar(s_entries, 1);
@@ -0,0 +1,192 @@
+#include "openswf_common.hpp"
+
+#include <chrono>
+#include <vector>
+
+using namespace openswf;
+
+// the byte-at-a-time bit reader used by Stream before the 64-bit bit cache,
+// kept here as the baseline of benchmark.
+class LegacyBitReader
+{
+protected:
+    const uint8_t*  m_data;
+    uint32_t        m_offset;
+    uint8_t         m_current_byte;
+    uint32_t        m_unused_bits;
+
+public:
+    LegacyBitReader(const uint8_t* raw)
+    : m_data(raw), m_offset(0), m_current_byte(0), m_unused_bits(0) {}
+
+    uint32_t read_bits_as_uint32(const int bitcount)
+    {
+        uint32_t value = 0;
+        uint16_t bits_needed = bitcount;
+        while( bits_needed > 0 ) {
+            if( m_unused_bits > 0 ) {
+                if( bits_needed >= m_unused_bits ) {
+                    value |= (m_current_byte << (bits_needed - m_unused_bits));
+                    bits_needed -= m_unused_bits;
+                    m_current_byte = 0;
+                    m_unused_bits = 0;
+                } else {
+                    value |= (m_current_byte >> (m_unused_bits - bits_needed));
+                    m_current_byte &= ((1 << (m_unused_bits - bits_needed)) -1);
+                    m_unused_bits -= bits_needed;
+                    bits_needed = 0;
+                }
+            } else {
+                m_current_byte = m_data[m_offset++];
+                m_unused_bits = 8;
+            }
+        }
+        return value;
+    }
+
+    int32_t read_bits_as_int32(const int bitcount)
+    {
+        int32_t value = (int32_t)read_bits_as_uint32(bitcount);
+        if( value & (1<<(bitcount-1)) ) value |= ((~0) << bitcount);
+        return value;
+    }
+};
+
+// a fixed sequence of bit widths, shaped like shape records:
+// mostly short flags and nbits fields mixed with some wide coordinates.
+static std::vector<int> create_widths(uint32_t count)
+{
+    std::vector<int> widths;
+    uint32_t seed = 0x2545f491;
+    for( auto i=0; i<count; i++ )
+    {
+        seed = seed * 1664525 + 1013904223;
+        auto r = (seed >> 24) & 0xff;
+        if( r < 96 )        widths.push_back(1);
+        else if( r < 160 )  widths.push_back(4 + (r & 0x1));
+        else                widths.push_back(2 + (r % 31));
+    }
+    return widths;
+}
+
+template<typename T>
+static uint32_t read_body(T& reader, const std::vector<int>& widths, uint32_t total_bits)
+{
+    uint32_t checksum = 0;
+    uint32_t consumed = 0;
+    for( auto width : widths )
+    {
+        if( consumed + width > total_bits )
+            break;
+
+        consumed += width;
+        if( width & 0x1 )
+            checksum = checksum * 31 + (uint32_t)reader.read_bits_as_int32(width);
+        else
+            checksum = checksum * 31 + reader.read_bits_as_uint32(width);
+    }
+    return checksum;
+}
+
+struct Body
+{
+    const uint8_t*  data;
+    uint32_t        size;
+};
+
+static std::vector<Body> collect_shape_bodies(Stream& stream)
+{
+    std::vector<Body> bodies;
+
+    stream.set_position(0);
+    SWFHeader::read(stream);
+    while( !stream.is_finished() )
+    {
+        auto tag = TagHeader::read(stream);
+        if( tag.code == TagCode::DEFINE_SHAPE ||
+            tag.code == TagCode::DEFINE_SHAPE2 ||
+            tag.code == TagCode::DEFINE_SHAPE3 ||
+            tag.code == TagCode::DEFINE_SHAPE4 )
+        {
+            bodies.push_back({ stream.get_current_ptr(), tag.end_pos - stream.get_position() });
+        }
+
+        if( tag.code == TagCode::END )
+            break;
+        stream.set_position(tag.end_pos);
+    }
+
+    return bodies;
+}
+
+template<typename F>
+static double measure(const std::vector<Body>& bodies, uint32_t iterations, uint32_t& checksum, F&& f)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    checksum = 0;
+    for( auto i=0; i<iterations; i++ )
+        for( auto& body : bodies )
+            checksum ^= f(body);
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    const char* defaults[] = {
+        "../test/resources/simple-shape-1.swf",
+        "../test/resources/simple-shape-2.swf",
+        "../test/resources/simple-timeline-1.swf",
+        "../test/resources/simple-timeline-2.swf"
+    };
+
+    std::vector<const char*> paths;
+    if( argc > 1 )
+        for( auto i=1; i<argc; i++ ) paths.push_back(argv[i]);
+    else
+        for( auto path : defaults ) paths.push_back(path);
+
+    const uint32_t iterations = 2000;
+    auto widths = create_widths(1 << 16);
+    auto success = true;
+
+    for( auto path : paths )
+    {
+        auto stream = create_from_file(path);
+        auto bodies = collect_shape_bodies(stream);
+
+        uint32_t bytes = 0;
+        for( auto& body : bodies ) bytes += body.size;
+        if( bytes == 0 )
+        {
+            printf("%s: no shape found.\n", path);
+            continue;
+        }
+
+        uint32_t legacy_checksum, cached_checksum;
+        auto legacy = measure(bodies, iterations, legacy_checksum, [&](const Body& body)
+        {
+            auto reader = LegacyBitReader(body.data);
+            return read_body(reader, widths, body.size*8);
+        });
+
+        auto cached = measure(bodies, iterations, cached_checksum, [&](const Body& body)
+        {
+            auto reader = Stream(body.data, body.size);
+            return read_body(reader, widths, body.size*8);
+        });
+
+        auto mb = (double)bytes * iterations / (1024.0 * 1024.0);
+        printf("%s: %d shapes, %d bytes\n", path, (int)bodies.size(), bytes);
+        printf("    legacy: %8.2f ms %8.2f MB/s\n", legacy, mb / (legacy / 1000.0));
+        printf("    cached: %8.2f ms %8.2f MB/s (x%.2f)\n", cached, mb / (cached / 1000.0), legacy / cached);
+
+        if( legacy_checksum != cached_checksum )
+        {
+            printf("    checksum mismatch: %08x != %08x\n", legacy_checksum, cached_checksum);
+            success = false;
+        }
+    }
+
+    return success ? 0 : -1;
+}
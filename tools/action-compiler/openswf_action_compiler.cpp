@@ -0,0 +1,100 @@
+// translates the DoAction tags of shipped swf files into c++ functions,
+// the generated source is compiled into the application, and the blocks of
+// the same bytecode run the functions instead of being interpreted.
+//
+//     action-compiler -o precompiled_actions.cpp movie.swf [more.swf ...]
+
+#include "openswf.hpp"
+#include "swf/decompressor.hpp"
+#include "avm/action_translator.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using namespace openswf;
+
+static bool translate_file(const char* path, avm::ActionTranslator& translator)
+{
+    auto file = FileSource::create(path);
+    if( file == nullptr )
+    {
+        fprintf(stderr, "failed to open %s.\n", path);
+        return false;
+    }
+
+    auto stream = file->get_stream();
+    auto decompressor = Decompressor::create(stream);
+    if( decompressor != nullptr )
+    {
+        if( !decompressor->advance(decompressor->get_size()) )
+        {
+            fprintf(stderr, "failed to decompress %s.\n", path);
+            return false;
+        }
+        stream = decompressor->get_stream();
+    }
+
+    auto index = TagIndex::create(stream);
+    if( index == nullptr )
+    {
+        fprintf(stderr, "failed to scan the tags of %s.\n", path);
+        return false;
+    }
+
+    // actions of sprites are indexed along with the ones of root
+    auto blocks = 0;
+    for( uint32_t i=0; i<index->get_tag_count(); i++ )
+    {
+        auto& tag = index->get_tag(i);
+        if( tag.code != TagCode::DO_ACTION )
+            continue;
+
+        stream.set_position(tag.offset);
+        if( !translator.add(stream.get_current_ptr(), tag.size) )
+            fprintf(stderr, "%s: failed to translate the actions at %d.\n", path, tag.offset);
+        else
+            blocks ++;
+    }
+
+    printf("%s: %d action blocks.\n", path, blocks);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* output = nullptr;
+    std::vector<const char*> inputs;
+
+    for( int i=1; i<argc; i++ )
+    {
+        if( strcmp(argv[i], "-o") == 0 && i+1 < argc )
+            output = argv[++i];
+        else
+            inputs.push_back(argv[i]);
+    }
+
+    if( output == nullptr || inputs.empty() )
+    {
+        fprintf(stderr, "usage: %s -o output.cpp input.swf [input.swf ...]\n", argv[0]);
+        return 1;
+    }
+
+    avm::ActionTranslator translator;
+    for( auto input : inputs )
+    {
+        if( !translate_file(input, translator) )
+            return 1;
+    }
+
+    std::ofstream handle(output, std::ofstream::out | std::ofstream::trunc);
+    if( !handle.is_open() )
+    {
+        fprintf(stderr, "failed to write %s.\n", output);
+        return 1;
+    }
+
+    handle << translator.get_source();
+    printf("%d functions are written to %s.\n", translator.get_function_count(), output);
+    return 0;
+}